@@ -0,0 +1,469 @@
+////////////////////////////////////////////////////////////////////////////////
+// batchMain.cpp
+//   lz factorization of many files in one process (lzBatch)
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lzbg.hpp"
+#include "lzFile.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <deque>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace LZBG;
+
+static const char * variantNames[] = {
+  "bgs", "bgl", "bgt", "ibgs", "ibgl", "ibgt", "og", "iog"
+};
+static const Variant variants[] = {
+  BGS, BGL, BGT, IBGS, IBGL, IBGT, OG, IOG
+};
+
+// regular files in directory dir, sorted by name,
+// except for those ending with ext (the factor files of a previous run)
+static bool listDirectory(const std::string & dir, const std::string & ext,
+			  std::vector<std::string> & files){
+  DIR * d = opendir(dir.c_str());
+  if(!d) return false;
+  struct dirent * e;
+  while((e = readdir(d)) != 0){
+    const std::string name = e->d_name;
+    if(!ext.empty() && name.size() >= ext.size() &&
+       name.compare(name.size() - ext.size(), ext.size(), ext) == 0) continue;
+    const std::string path = dir + "/" + name;
+    struct stat st;
+    if(stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) files.push_back(path);
+  }
+  closedir(d);
+  std::sort(files.begin(), files.end());
+  return true;
+}
+
+////////////////////////////////////////////////////////////
+// the files are processed in three stages that overlap, so that
+// the cpus do not wait for the disk:
+//   reader : reads the next files into the page cache (-R)
+//   workers: factorize the files (-j at once)
+//   writer : writes the factor files of the finished ones (-e)
+//
+// the workers take the files from a shared queue, largest first.
+// a file is started only if its working memory (workingMemory(),
+// the text, and the buffer for -g) fits in the limit, together with
+// that of the running files, the workspaces kept by the workers, and
+// the factor files waiting for the writer. if the largest file does
+// not fit, a smaller one is taken instead. a file that does not fit
+// at all is run alone.
+////////////////////////////////////////////////////////////
+struct Job {
+  std::string file;
+  size_t n, memory;
+  bool read;                     // seen by the reader
+  size_t ahead;                  // bytes read ahead
+  bool operator<(const Job & j) const {
+    return n != j.n ? n > j.n : file < j.file;
+  }
+};
+
+// factorization of a file, waiting for the writer
+struct Output {
+  std::string file, msg;
+  size_t n;
+  std::vector<char> data;
+};
+
+struct Batch {
+  Variant v;
+  std::string ext;
+  bool check;
+  int jobThreads;                // threads for each file
+  std::vector<Job> jobs;         // not started yet, largest first
+  size_t limit, used, peak;      // bytes of memory
+  int running;
+  size_t readAhead, ahead;       // bytes of files read, but not started
+  std::deque<Output *> outputs;  // waiting for the writer
+  bool closing;                  // all files are factorized
+  size_t done, failed;
+  uint64_t bytes;
+  pthread_mutex_t lock;
+  pthread_cond_t finished;       // memory was released
+  pthread_cond_t started;        // a file was taken by a worker
+  pthread_cond_t queued;         // an output was queued
+};
+
+// working memory of a worker kept across its files
+struct Worker {
+  Batch * batch;
+  Workspace ws;
+  std::vector<char> decoded;
+  size_t bytes() const {
+    return ws.sa.size() + ws.aux1.size() + ws.aux2.size()
+      + ws.bucket.size() + decoded.size();
+  }
+  void release(){
+    std::vector<char>().swap(ws.sa);
+    std::vector<char>().swap(ws.aux1);
+    std::vector<char>().swap(ws.aux2);
+    std::vector<char>().swap(ws.bucket);
+    std::vector<char>().swap(decoded);
+  }
+};
+
+// factorize one file into o (the factors are encoded with -e).
+// return 0 and a result line in o.msg, or an error message.
+static int processFile(Worker & w, const Job & j, Output & o){
+  const Batch & b = *w.batch;
+  double t1 = gettime();
+  std::ostringstream os;
+  if(access(j.file.c_str(), R_OK) != 0){
+    o.msg = "ERROR: failed to read file: " + j.file;
+    return 1;
+  }
+  Text s;
+  if(!s.mapFile(j.file)) s.readFile(j.file);
+  const size_t n = s.size();
+
+  EncodeSink * es = b.ext.empty() ? 0 : new EncodeSink(n);
+  if(b.check && w.decoded.size() < n) w.decoded.resize(n);
+  // the factors are counted, and passed on to the decoder (-g) and the file
+  DecodeSink ds(w.decoded.empty() ? 0 : &w.decoded[0], n, es);
+  CountSink sink(0, b.check ? static_cast<Sink *>(&ds) : es);
+  int err = factorize(reinterpret_cast<const uint8_t *>(s.data()), n, b.v, sink, w.ws);
+  if(es){
+    es->finish();
+    o.data.swap(es->data());
+    delete es;
+  }
+  if(err){
+    o.msg = "ERROR: failed to factorize: " + j.file;
+    return 1;
+  }
+  if(b.check && (!ds.good() || ds.size() != static_cast<int64_t>(n) ||
+		 (n && memcmp(&w.decoded[0], s.data(), n) != 0))){
+    o.msg = "CHECK: ERROR: mismatch: " + j.file;
+    return 1;
+  }
+  os << j.file << "\t" << n << "\t" << sink.count << "\t" << gettime() - t1;
+  o.file = j.file;
+  o.n = n;
+  o.msg = os.str();
+  return 0;
+}
+
+static void * worker(void * arg){
+  Worker w;
+  w.batch = static_cast<Batch *>(arg);
+  Batch & b = *w.batch;
+#ifdef _OPENMP
+  omp_set_num_threads(b.jobThreads);
+#endif
+  size_t held = 0; // bytes of w included in b.used
+  pthread_mutex_lock(&b.lock);
+  while(!b.jobs.empty()){
+    size_t k, cost = 0;
+    for(k = 0; k < b.jobs.size(); k++){
+      const Job & j = b.jobs[k];
+      cost = (j.memory > held ? j.memory - held : 0) + j.n;
+      if(b.used + cost <= b.limit || b.running == 0) break;
+    }
+    if(k == b.jobs.size()){
+      // nothing fits: give back the workspace, or wait for memory
+      if(held){
+	w.release();
+	b.used -= held;
+	held = 0;
+      } else {
+	pthread_cond_wait(&b.finished, &b.lock);
+      }
+      continue;
+    }
+    const Job j = b.jobs[k];
+    b.jobs.erase(b.jobs.begin() + k);
+    b.ahead -= j.ahead;
+    pthread_cond_signal(&b.started);
+    const size_t reserved = std::max(held, j.memory);
+    b.used += cost;
+    b.peak = std::max(b.peak, b.used);
+    b.running++;
+    pthread_mutex_unlock(&b.lock);
+
+    Output * o = new Output;
+    int err = processFile(w, j, *o);
+
+    pthread_mutex_lock(&b.lock);
+    held = w.bytes();
+    b.used = b.used - reserved - j.n + held;
+    b.running--;
+    if(err){
+      b.failed++;
+      std::cerr << o->msg << std::endl;
+      delete o;
+    } else if(!b.ext.empty()){
+      b.used += o->data.size();
+      b.peak = std::max(b.peak, b.used);
+      b.outputs.push_back(o);
+      pthread_cond_signal(&b.queued);
+    } else {
+      b.done++;
+      b.bytes += o->n;
+      std::cout << o->msg << std::endl;
+      delete o;
+    }
+    pthread_cond_broadcast(&b.finished);
+  }
+  pthread_mutex_unlock(&b.lock);
+  return 0;
+}
+
+// read the files ahead of the workers, in the order of the queue.
+// larger files than the read ahead are left to the workers.
+static void * reader(void * arg){
+  Batch & b = *static_cast<Batch *>(arg);
+  pthread_mutex_lock(&b.lock);
+  for(;;){
+    size_t k = 0;
+    while(k < b.jobs.size() && b.jobs[k].read) k++;
+    if(k == b.jobs.size()) break;
+    Job & j = b.jobs[k];
+    if(j.n > b.readAhead){
+      j.read = true;
+      continue;
+    }
+    if(b.ahead + j.n > b.readAhead){
+      pthread_cond_wait(&b.started, &b.lock);
+      continue;
+    }
+    j.read = true;
+    j.ahead = j.n;
+    b.ahead += j.n;
+    const std::string file = j.file;
+    pthread_mutex_unlock(&b.lock);
+    {
+      // the pages stay in the page cache after unmapping
+      Text s;
+      s.mapFile(file, Text::POPULATE);
+    }
+    pthread_mutex_lock(&b.lock);
+  }
+  pthread_mutex_unlock(&b.lock);
+  return 0;
+}
+
+// write the factor files in the order they are finished
+static void * writer(void * arg){
+  Batch & b = *static_cast<Batch *>(arg);
+  pthread_mutex_lock(&b.lock);
+  for(;;){
+    if(b.outputs.empty()){
+      if(b.closing) break;
+      pthread_cond_wait(&b.queued, &b.lock);
+      continue;
+    }
+    Output * o = b.outputs.front();
+    b.outputs.pop_front();
+    pthread_mutex_unlock(&b.lock);
+
+    const std::string outFile = o->file + b.ext;
+    std::ofstream ofs(outFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write(&o->data[0], o->data.size());
+    ofs.close();
+
+    pthread_mutex_lock(&b.lock);
+    b.used -= o->data.size();
+    if(ofs.good()){
+      b.done++;
+      b.bytes += o->n;
+      std::cout << o->msg << std::endl;
+    } else {
+      b.failed++;
+      std::cerr << "ERROR: failed to write file: " << outFile << std::endl;
+    }
+    delete o;
+    pthread_cond_broadcast(&b.finished);
+  }
+  pthread_mutex_unlock(&b.lock);
+  return 0;
+}
+
+static int maxThreads(){
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void print_usage_batch(char * argv []){
+  std::cout << "Usage  : " << argv[0] << " [options] < list" << std::endl
+	    << "Options: " << std::endl
+	    << "  -a name  : variant: bgs, bgl, bgt, ibgs (default), ibgl, ibgt, og, iog" << std::endl
+	    << "  -d dir   : process the files in dir (default: the files listed on" << std::endl
+	    << "             standard input, one per line; entries that are not regular" << std::endl
+	    << "             files are skipped)" << std::endl
+	    << "  -e ext   : write the factorization of each file to file + ext" << std::endl
+	    << "  -g       : check if resulting factorizations produce the input strings" << std::endl
+	    << "  -j num   : number of files processed at once (default: 1)" << std::endl
+	    << "  -M size  : memory for the files processed at once, in MB" << std::endl
+	    << "             (default: physical memory)" << std::endl
+	    << "  -R size  : read up to size MB of the next files ahead (default: 256)" << std::endl
+	    << "  -t num   : number of threads, shared by the files processed at once" << std::endl
+	    << "             (requires OpenMP, default: all cores)" << std::endl;
+}
+
+int main(int argc, char * argv[]){
+  int ch, jobs = 1, threads = maxThreads();
+  Variant v = IBGS;
+  std::string dir, ext;
+  bool check = false;
+  size_t limit = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+  size_t readAhead = size_t(256) << 20;
+  while ((ch = getopt(argc, argv, "a:d:e:gj:M:R:t:h")) != -1) {
+    switch (ch) {
+    case 'a': {
+      size_t k = 0;
+      while(k < 8 && strcmp(optarg, variantNames[k]) != 0) k++;
+      if(k == 8){
+	std::cerr << "ERROR: unknown variant: " << optarg << std::endl;
+	print_usage_batch(argv);
+	exit(1);
+      }
+      v = variants[k];
+      break;
+    }
+    case 'd':
+      dir = optarg;
+      break;
+    case 'e':
+      ext = optarg;
+      break;
+    case 'g':
+      check = true;
+      break;
+    case 'j':
+      jobs = atoi(optarg);
+      break;
+    case 'M':
+      limit = static_cast<size_t>(atoll(optarg)) << 20;
+      break;
+    case 'R':
+      readAhead = static_cast<size_t>(atoll(optarg)) << 20;
+      break;
+    case 't':
+      threads = atoi(optarg);
+      setThreads(threads);
+      break;
+    default:
+      print_usage_batch(argv);
+      exit(0);
+    }
+  }
+  if(jobs < 1 || threads < 1){
+    print_usage_batch(argv);
+    exit(0);
+  }
+
+  std::vector<std::string> files;
+  if(!dir.empty()){
+    if(!listDirectory(dir, ext, files)){
+      std::cerr << "ERROR: failed to open directory: " << dir << std::endl;
+      return 1;
+    }
+  } else {
+    std::string line;
+    while(std::getline(std::cin, line))
+      if(!line.empty()) files.push_back(line);
+  }
+
+  Batch b;
+  b.v = v;
+  b.ext = ext;
+  b.check = check;
+  b.jobThreads = std::max(1, threads / jobs);
+  b.limit = limit;
+  b.used = b.peak = 0;
+  b.running = 0;
+  b.readAhead = readAhead;
+  b.ahead = 0;
+  b.closing = false;
+  b.done = b.failed = 0;
+  b.bytes = 0;
+  for(size_t k = 0; k < files.size(); k++){
+    struct stat st;
+    if(stat(files[k].c_str(), &st) != 0){
+      std::cerr << "ERROR: failed to read file: " << files[k] << std::endl;
+      b.failed++;
+      continue;
+    }
+    if(!S_ISREG(st.st_mode)){ // as in listDirectory
+      std::cerr << "skipping (not a regular file): " << files[k] << std::endl;
+      continue;
+    }
+    Job j;
+    j.file = files[k];
+    j.n = st.st_size;
+    j.memory = workingMemory(j.n, v) + (check ? j.n : 0);
+    j.read = false;
+    j.ahead = 0;
+    b.jobs.push_back(j);
+  }
+  std::sort(b.jobs.begin(), b.jobs.end());
+  pthread_mutex_init(&b.lock, 0);
+  pthread_cond_init(&b.finished, 0);
+  pthread_cond_init(&b.started, 0);
+  pthread_cond_init(&b.queued, 0);
+
+  double t0 = gettime();
+  std::vector<pthread_t> pool(jobs);
+  pthread_t readerThread, writerThread;
+  bool ok = pthread_create(&readerThread, 0, reader, &b) == 0
+    && pthread_create(&writerThread, 0, writer, &b) == 0;
+  for(int k = 0; ok && k < jobs; k++)
+    ok = pthread_create(&pool[k], 0, worker, &b) == 0;
+  if(!ok){
+    std::cerr << "ERROR: failed to create thread" << std::endl;
+    exit(1);
+  }
+  for(int k = 0; k < jobs; k++) pthread_join(pool[k], 0);
+  pthread_mutex_lock(&b.lock);
+  b.closing = true;
+  pthread_cond_signal(&b.queued);
+  pthread_mutex_unlock(&b.lock);
+  pthread_join(writerThread, 0);
+  pthread_join(readerThread, 0);
+  double t = gettime() - t0;
+  if(t <= 0) t = 1e-9;
+  pthread_cond_destroy(&b.queued);
+  pthread_cond_destroy(&b.started);
+  pthread_cond_destroy(&b.finished);
+  pthread_mutex_destroy(&b.lock);
+
+  std::cout << "files: " << b.done << " (" << b.failed << " failed)"
+	    << ", bytes: " << b.bytes << ", time: " << t
+	    << ", files/s: " << b.done / t
+	    << ", MB/s: " << b.bytes / t / 1e6 << std::endl;
+  std::cout << "files at once: " << jobs << ", threads each: " << b.jobThreads
+	    << ", memory: " << (b.peak >> 20) << "MB (limit " << (limit >> 20) << "MB)"
+	    << std::endl;
+  return b.failed ? 1 : 0;
+}
@@ -0,0 +1,577 @@
+////////////////////////////////////////////////////////////////////////////////
+// benchMain.cpp
+//   benchmarks for the phases of lz factorization
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bgCommon.hpp"
+#include "bgLCP.hpp"
+#include "lzFile.hpp"
+#include "lzAccess.hpp"
+#include "bgCache.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LZBG_RDTSC
+#endif
+
+using namespace LZBG;
+
+////////////////////////////////////////////////////////////
+// bytes allocated with new, and their peak since resetPeak()
+// (for the memory of the factorization)
+////////////////////////////////////////////////////////////
+static volatile int64_t heapBytes = 0, heapPeak = 0;
+
+static void resetPeak(){ heapPeak = heapBytes; }
+
+void * operator new(size_t size){
+  void * p = malloc(size + 16);
+  if(!p) throw std::bad_alloc();
+  *static_cast<size_t *>(p) = size;
+  const int64_t b = __sync_add_and_fetch(&heapBytes, int64_t(size));
+  for(int64_t m = heapPeak; b > m && !__sync_bool_compare_and_swap(&heapPeak, m, b); m = heapPeak);
+  return static_cast<char *>(p) + 16;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) throw(){
+  try { return operator new(size); } catch(...) { return 0; }
+}
+
+void operator delete(void * p) throw(){
+  if(!p) return;
+  p = static_cast<char *>(p) - 16;
+  __sync_sub_and_fetch(&heapBytes, int64_t(*static_cast<size_t *>(p)));
+  free(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) throw(){
+  operator delete(p);
+}
+
+static int maxThreads(){
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+////////////////////////////////////////////////////////////
+// suffix array construction with 1, 2, 4, ..., maxt threads
+////////////////////////////////////////////////////////////
+void benchSA(const std::string & s, int maxt, int reps){
+  const unsigned char * T = reinterpret_cast<const unsigned char *>(s.c_str());
+  const savalue_t n = s.size();
+  std::vector<saidx_t> sa(n), sa1(n);
+  double t1 = 0;
+  std::cout << "threads\ttime\tspeedup" << std::endl;
+  for(int t = 1; ; t = (t * 2 > maxt && t < maxt) ? maxt : t * 2){
+    setThreads(t);
+    double best = 0;
+    for(int r = 0; r < reps; r++){
+      double t0 = gettime();
+      divsufsort(T, &sa[0], n, n);
+      double e = gettime() - t0;
+      if(r == 0 || e < best) best = e;
+    }
+    if(t == 1){
+      t1 = best;
+      sa1 = sa;
+    } else {
+      for(savalue_t i = 0; i < n; i++){
+	if(savalue_t(sa[i]) != savalue_t(sa1[i])){
+	  std::cerr << "ERROR: suffix array differs for " << t << " threads" << std::endl;
+	  exit(1);
+	}
+      }
+    }
+    std::cout << t << "\t" << best << "\t" << t1 / best << std::endl;
+    if(t >= maxt) break;
+  }
+}
+
+////////////////////////////////////////////////////////////
+// PSV, NSV in lex order with 1, 2, 4, ..., maxt threads
+// (stack and peak elimination, separate and interleaved)
+////////////////////////////////////////////////////////////
+void benchPNSV(const std::string & s, int maxt, int reps){
+  const unsigned char * T = reinterpret_cast<const unsigned char *>(s.c_str());
+  const savalue_t n = s.size();
+  std::vector<saidx_t> sa(n), pnsv(2 * n), pnsv1[4];
+  setThreads(maxt);
+  divsufsort(T, &sa[0], n, n);
+  double t1[4];
+  std::cout << "threads\tstack\tistack\tlex\tilex\tspeedup(stack,istack,lex,ilex)" << std::endl;
+  for(int t = 1; ; t = (t * 2 > maxt && t < maxt) ? maxt : t * 2){
+    setThreads(t);
+    double best[4];
+    for(int k = 0; k < 4; k++){
+      for(int r = 0; r < reps; r++){
+	double t0 = gettime();
+	switch(k){
+	case 0: pnsvStack(&sa[0], n, &pnsv[0], &pnsv[n]); break;
+	case 1: pnsvStack(&sa[0], n, &pnsv[0]); break;
+	case 2: pnsvLex(&sa[0], n, &pnsv[0], &pnsv[n]); break;
+	case 3: pnsvLex(&sa[0], n, &pnsv[0]); break;
+	}
+	double e = gettime() - t0;
+	if(r == 0 || e < best[k]) best[k] = e;
+      }
+      if(t == 1){
+	t1[k] = best[k];
+	pnsv1[k] = pnsv;
+      } else {
+	for(savalue_t i = 0; i < 2 * n; i++){
+	  if(savalue_t(pnsv[i]) != savalue_t(pnsv1[k][i])){
+	    std::cerr << "ERROR: PSV/NSV differs for " << t << " threads" << std::endl;
+	    exit(1);
+	  }
+	}
+      }
+    }
+    std::cout << t;
+    for(int k = 0; k < 4; k++) std::cout << "\t" << best[k];
+    for(int k = 0; k < 4; k++) std::cout << (k ? "," : "\t") << t1[k] / best[k];
+    std::cout << std::endl;
+    if(t >= maxt) break;
+  }
+}
+
+////////////////////////////////////////////////////////////
+// lcp kernels on prefixes of the input with the first mismatch
+// at len, compared to the former byte loop (naive)
+////////////////////////////////////////////////////////////
+static size_t naiveLCP(const char * a, const char * b, size_t max){
+  size_t l = 0;
+  while(l < max && a[l] == b[l]) l++;
+  return l;
+}
+
+void benchLCP(const std::string & s, int reps){
+  static const size_t lens[] = { 4, 16, 64, 256, 4096, 65536, 1 << 20, 1 << 24 };
+  const char * const * names = lcpKernelNames();
+  const std::string def = lcpKernelName();
+  std::cout << "len";
+  std::cout << "\tnaive";
+  for(size_t k = 0; names[k]; k++) std::cout << "\t" << names[k];
+#ifdef LZBG_RDTSC
+  std::cout << "\t(bytes/cycle)" << std::endl;
+#else
+  std::cout << "\t(GB/s)" << std::endl;
+#endif
+  for(size_t li = 0; li < sizeof(lens) / sizeof(lens[0]) && lens[li] < s.size(); li++){
+    const size_t len = lens[li];
+    std::string t(s, 0, len + 1);
+    t[len] = ~t[len];
+    const size_t calls = (size_t(1) << 28) / len + 1;
+    std::cout << len;
+    for(size_t k = 0; k == 0 || names[k - 1]; k++){
+      if(k > 0) setLCPKernel(names[k - 1]);
+      double best = 0;
+      for(int r = 0; r < reps; r++){
+	size_t sum = 0;
+#ifdef LZBG_RDTSC
+	uint64_t t0 = __rdtsc();
+#else
+	double t0 = gettime();
+#endif
+	for(size_t c = 0; c < calls; c++){
+	  // vary the offset by one bit so that calls are not hoisted
+	  sum += (k == 0) ? naiveLCP(s.c_str(), t.c_str(), len + 1 - (c & 1))
+	    : lcp(s.c_str(), t.c_str(), len + 1 - (c & 1));
+	}
+#ifdef LZBG_RDTSC
+	double e = double(__rdtsc() - t0);
+#else
+	double e = (gettime() - t0) * 1e9;
+#endif
+	if(sum != calls * len){
+	  std::cerr << "ERROR: lcp mismatch for length " << len << std::endl;
+	  exit(1);
+	}
+	if(r == 0 || double(sum) / e > best) best = double(sum) / e;
+      }
+      std::cout << "\t" << best;
+    }
+    std::cout << std::endl;
+  }
+  setLCPKernel(def.c_str());
+}
+
+////////////////////////////////////////////////////////////
+// peak elimination and sop on highly repetitive texts of length n,
+// where chains of PSV/NSV and LPF are long
+////////////////////////////////////////////////////////////
+static std::string genText(const std::string & name, savalue_t n){
+  std::string s;
+  if(name == "fib"){ // Fibonacci word
+    std::string a = "a", b = "ab";
+    while(savalue_t(b.size()) < n){ std::string c = b + a; a.swap(b); b.swap(c); }
+    s = b;
+  } else if(name == "tm"){ // Thue-Morse word
+    for(savalue_t i = 0; i < n; i++) s.push_back(__builtin_parityll(i) ? 'b' : 'a');
+  } else if(name == "run"){ // single run
+    s.assign(n, 'a');
+  } else { // runs of random length in [1, 1000] of random characters
+    srand(1);
+    while(savalue_t(s.size()) < n) s.append(1 + rand() % 1000, 'a' + rand() % 4);
+  }
+  s.resize(n);
+  return s;
+}
+
+void benchStress(savalue_t n, int reps){
+  static const char * texts[] = { "fib", "tm", "run", "runs" };
+  std::cout << "text\tstack\tistack\tlex\tilex\ttext\titext\tlpf\tilpf" << std::endl;
+  for(size_t k = 0; k < sizeof(texts) / sizeof(texts[0]); k++){
+    const std::string s = genText(texts[k], n);
+    const unsigned char * T = reinterpret_cast<const unsigned char *>(s.c_str());
+    std::vector<saidx_t> sa(n), phi(n), phi0(n), work(2 * n);
+    divsufsort(T, &sa[0], n, n);
+    phi[sa[0]] = sa[n-1];
+    phi0[sa[0]] = -1;
+    for(savalue_t i = 1; i < n; i++) phi[sa[i]] = phi0[sa[i]] = sa[i-1];
+    std::cout << texts[k];
+    for(int v = 0; v < 8; v++){
+      double best = 0;
+      for(int r = 0; r < reps; r++){
+	double t0 = gettime();
+	switch(v){
+	case 0: pnsvStack(&sa[0], n, &work[0], &work[n]); break;
+	case 1: pnsvStack(&sa[0], n, &work[0]); break;
+	case 2: pnsvLex(&sa[0], n, &work[0], &work[n]); break;
+	case 3: pnsvLex(&sa[0], n, &work[0]); break;
+	case 4: pnsvText(&phi[0], n, &work[0], &work[n]); break;
+	case 5: pnsvText(&phi[0], n, &work[0]); break;
+	case 6: lpfPrevOcc(s.c_str(), n, &phi0[0], &work[0], &work[n]); break;
+	case 7: lpfPrevOcc(s.c_str(), n, &phi0[0], &work[0]); break;
+	}
+	double e = gettime() - t0;
+	if(r == 0 || e < best) best = e;
+      }
+      std::cout << "\t" << best;
+    }
+    std::cout << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////
+// decoding the factorization of the input, compared to the
+// former lz2str that appended one character at a time
+////////////////////////////////////////////////////////////
+static std::string naiveDecode(const std::vector<std::pair<int64_t,int64_t> > & lz){
+  std::string s;
+  for(size_t i = 0; i < lz.size(); i++){
+    if(lz[i].first == 0) s.push_back(static_cast<char>(lz[i].second));
+    else for(int64_t j = 0; j < lz[i].first; j++) s.push_back(s[lz[i].second + j]);
+  }
+  return s;
+}
+
+// factorization of s by BGT
+static void factorize(const std::string & s, Sink & sink){
+  const unsigned char * T = reinterpret_cast<const unsigned char *>(s.c_str());
+  const savalue_t n = s.size();
+  std::vector<saidx_t> sa(n), psv(n);
+  divsufsort(T, &sa[0], n, n);
+  pnsvTextFromSA(&sa[0], n, &psv[0]);
+  lzFromTOPNSV(s.c_str(), n, &psv[0], &sa[0], sink);
+}
+
+////////////////////////////////////////////////////////////
+// lz factorization (BGT) with 1, 2, 4, ..., maxt threads, and the
+// peak memory allocated while the factors are passed to sink,
+// which should stay within 2 * LZ_BLOCK factors per thread
+////////////////////////////////////////////////////////////
+void benchLZ(const std::string & s, int maxt, int reps){
+  const unsigned char * T = reinterpret_cast<const unsigned char *>(s.c_str());
+  const savalue_t n = s.size();
+  std::vector<saidx_t> sa(n), psv(n);
+  setThreads(maxt);
+  divsufsort(T, &sa[0], n, n);
+  pnsvTextFromSA(&sa[0], n, &psv[0]);
+  size_t count1 = 0;
+  double t1 = 0;
+  std::cout << "threads	time	speedup	buffered(MB)	limit(MB)" << std::endl;
+  for(int t = 1; ; t = (t * 2 > maxt && t < maxt) ? maxt : t * 2){
+    setThreads(t);
+    const int64_t limit = (t > 1) ? t * 2 * LZ_BLOCK * int64_t(sizeof(std::pair<savalue_t,savalue_t>)) : 0;
+    double best = 0;
+    int64_t peak = 0;
+    for(int r = 0; r < reps; r++){
+      CountSink sink;
+      const int64_t before = heapBytes;
+      resetPeak();
+      double t0 = gettime();
+      lzFromTOPNSV(s.c_str(), n, &psv[0], &sa[0], sink);
+      double e = gettime() - t0;
+      peak = std::max(peak, int64_t(heapPeak) - before);
+      if(r == 0 || e < best) best = e;
+      if(t == 1) count1 = sink.count;
+      if(sink.count != count1){
+	std::cerr << "ERROR: number of factors differs for " << t << " threads" << std::endl;
+	exit(1);
+      }
+    }
+    if(t == 1) t1 = best;
+    std::cout << t << "\t" << best << "\t" << t1 / best << "\t" << peak / 1048576.0
+	      << "\t" << limit / 1048576.0 << std::endl;
+    if(peak > limit + (1 << 20)){ // besides the runtime of the threads
+      std::cerr << "ERROR: the buffered factors exceed the limit for " << t << " threads" << std::endl;
+      exit(1);
+    }
+    if(t >= maxt) break;
+  }
+  std::cout << "# of lz factors: " << count1 << std::endl;
+}
+
+void benchDecode(const std::string & s, int reps){
+  const savalue_t n = s.size();
+  std::vector<std::pair<int64_t,int64_t> > lz;
+  VectorSink sink(lz);
+  factorize(s, sink);
+  char tmp[] = "/tmp/lzBenchXXXXXX";
+  int fd = mkstemp(tmp);
+  if(fd < 0){
+    std::cerr << "ERROR: failed to create temporary file" << std::endl;
+    exit(1);
+  }
+  close(fd);
+  {
+    FileSink out(tmp, n);
+    for(size_t i = 0; i < lz.size(); i++) out.factor(lz[i].first, lz[i].second);
+  }
+  std::cout << "# of lz factors: " << lz.size() << std::endl;
+  std::cout << "decoder\ttime\tGB/s" << std::endl;
+  static const char * names[] = { "push_back", "lz2str", "file" };
+  for(int k = 0; k < 3; k++){
+    double best = 0;
+    for(int r = 0; r < reps; r++){
+      std::string t;
+      double t0 = gettime();
+      switch(k){
+      case 0: t = naiveDecode(lz); break;
+      case 1: t = lz2str(lz); break;
+      case 2: decodeFile(tmp, t); break;
+      }
+      double e = gettime() - t0;
+      if(t != s){
+	std::cerr << "ERROR: " << names[k] << " decoded a different string" << std::endl;
+	unlink(tmp);
+	exit(1);
+      }
+      if(r == 0 || e < best) best = e;
+    }
+    std::cout << names[k] << "\t" << best << "\t" << n / best * 1e-9 << std::endl;
+  }
+  unlink(tmp);
+}
+
+////////////////////////////////////////////////////////////
+// extraction of substrings at random positions from LZIndex,
+// with chains of previous occurrences cut at several depths
+////////////////////////////////////////////////////////////
+void benchExtract(const std::string & s, int reps){
+  static const int depths[] = { 4, 16, 64 };
+  static const int64_t lens[] = { 1, 16, 256, 4096 };
+  const int64_t n = s.size();
+  std::vector<std::pair<int64_t,int64_t> > lz;
+  VectorSink sink(lz);
+  factorize(s, sink);
+  std::cout << "# of lz factors: " << lz.size() << std::endl;
+  std::cout << "depth\tbuild\tfactors\texplicit";
+  for(size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) std::cout << "\tlen=" << lens[l];
+  std::cout << "\t(latency in microseconds)" << std::endl;
+  std::vector<char> out(lens[sizeof(lens) / sizeof(lens[0]) - 1]);
+  for(size_t k = 0; k < sizeof(depths) / sizeof(depths[0]); k++){
+    double t0 = gettime();
+    LZIndex index(depths[k]);
+    for(size_t i = 0; i < lz.size(); i++) index.factor(lz[i].first, lz[i].second);
+    index.finish();
+    std::cout << depths[k] << "\t" << gettime() - t0 << "\t" << index.factors() << "\t" << index.explicitChars();
+    for(size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++){
+      const int64_t len = std::min(lens[l], n), queries = 1 + (int64_t(1) << 24) / (len + 64);
+      double best = 0;
+      for(int r = 0; r <= reps; r++){ // r = 0: check the substrings
+	uint64_t x = 88172645463325252ULL; // xorshift
+	t0 = gettime();
+	for(int64_t q = 0; q < queries; q++){
+	  x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+	  const int64_t i = x % (n - len + 1);
+	  index.extract(i, len, &out[0]);
+	  if(r == 0 && memcmp(&out[0], s.c_str() + i, len) != 0){
+	    std::cerr << "ERROR: extracted a different substring at " << i << std::endl;
+	    exit(1);
+	  }
+	}
+	double e = gettime() - t0;
+	if(r == 1 || e < best) best = e;
+      }
+      std::cout << "\t" << best / queries * 1e6;
+    }
+    std::cout << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////
+// suffix array cache: size and load time of the raw and the
+// compressed cache, compared to building the suffix array
+////////////////////////////////////////////////////////////
+void benchCache(const std::string & inFile, int reps){
+  Text s;
+  if(!s.mapFile(inFile)) s.readFile(inFile);
+  const unsigned char * T = reinterpret_cast<const unsigned char *>(s.data());
+  const savalue_t n = s.size();
+  const size_t size = sizeof(saidx_t) * n;
+  std::vector<saidx_t> sa(n), sa1(n);
+  char tmp[] = "/tmp/lzBenchXXXXXX";
+  int fd = mkstemp(tmp);
+  if(fd < 0){
+    std::cerr << "ERROR: failed to create temporary file" << std::endl;
+    exit(1);
+  }
+  close(fd);
+  std::cout << "cache\tsize\twrite\tload" << std::endl;
+  double best = 0;
+  for(int r = 0; r < reps; r++){
+    double t0 = gettime();
+    divsufsort(T, &sa[0], n, n);
+    double e = gettime() - t0;
+    if(r == 0 || e < best) best = e;
+  }
+  std::cout << "none\t0\t0\t" << best << std::endl;
+  for(int k = 0; k < 2; k++){
+    const CacheHeader h = cacheHeader(s, sizeof(saidx_t), k ? "sa-psi" : "sa", "bench");
+    std::string z;
+    double t0 = gettime();
+    if(k){
+      saCompress(s.data(), &sa[0], n, z);
+      writeCache(tmp, h, z.data(), z.size());
+    } else {
+      writeCache(tmp, h, &sa[0], size);
+    }
+    const double w = gettime() - t0;
+    for(int r = 0; r < reps; r++){
+      std::fill(sa1.begin(), sa1.end(), 0);
+      t0 = gettime();
+      bool ok = false;
+      if((fd = openCache(tmp, h, k ? -1 : int64_t(size))) >= 0){
+	if(k){
+	  std::string y(cacheSize(fd), '\0');
+	  ok = readCache(fd, &y[0], y.size()) && saDecompress(y.data(), y.size(), n, &sa1[0]);
+	} else {
+	  ok = readCache(fd, &sa1[0], size);
+	}
+      }
+      double e = gettime() - t0;
+      if(!ok || memcmp(&sa[0], &sa1[0], size) != 0){
+	std::cerr << "ERROR: suffix array differs after loading the cache" << std::endl;
+	unlink(tmp);
+	exit(1);
+      }
+      if(r == 0 || e < best) best = e;
+    }
+    std::cout << (k ? "psi" : "raw") << "\t" << sizeof(CacheHeader) + (k ? z.size() : size)
+	      << "\t" << w << "\t" << best << std::endl;
+  }
+  unlink(tmp);
+}
+
+void print_usage_bench(char * argv []){
+  std::cout << "Usage  : " << argv[0] << " [options]" << std::endl
+	    << "Options: " << std::endl
+	    << "  -f iFile : file to process" << std::endl
+	    << "  -b name  : benchmark to run:" << std::endl
+	    << "             sa   : suffix array construction with 1, 2, 4, ... threads" << std::endl
+	    << "             pnsv : PSV, NSV in lex order with 1, 2, 4, ... threads" << std::endl
+	    << "             lcp  : lcp kernels on prefixes of iFile, in bytes/cycle" << std::endl
+	    << "             lz   : factorization (BGT) with 1, 2, 4, ... threads, and the" << std::endl
+	    << "                    memory of the factors buffered by the threads" << std::endl
+	    << "             cache : size and load time of the suffix array cache" << std::endl
+	    << "                     (raw and compressed), compared to building it" << std::endl
+	    << "             decode : decoding the factorization of iFile, in GB/s" << std::endl
+	    << "             extract : random access to substrings of iFile from its factorization" << std::endl
+	    << "             stress : peak elimination and sop on Fibonacci, Thue-Morse" << std::endl
+	    << "                      and run-heavy texts of length len (no iFile)" << std::endl
+	    << "  -n len   : text length for stress (default: 2^24)" << std::endl
+	    << "  -t num   : maximum number of threads (default: all cores)" << std::endl
+	    << "  -r num   : repetitions, the best time is reported (default: 3)" << std::endl;
+}
+
+int main(int argc, char * argv[]){
+  int ch, maxt = maxThreads(), reps = 3;
+  savalue_t len = 1 << 24;
+  std::string inFile, bench;
+  while ((ch = getopt(argc, argv, "f:b:t:r:n:h")) != -1) {
+    switch (ch) {
+    case 'f':
+      inFile = optarg;
+      break;
+    case 'b':
+      bench = optarg;
+      break;
+    case 't':
+      maxt = atoi(optarg);
+      break;
+    case 'r':
+      reps = atoi(optarg);
+      break;
+    case 'n':
+      len = atoll(optarg);
+      break;
+    default:
+      print_usage_bench(argv);
+      exit(0);
+    }
+  }
+  if(bench == "stress" && len > 0 && reps > 0){
+    benchStress(len, reps);
+    return 0;
+  }
+  if(inFile.empty() || bench.empty() || maxt < 1 || reps < 1){
+    print_usage_bench(argv);
+    exit(0);
+  }
+
+  std::string s;
+  stringFromFile(inFile, s);
+  std::cout << "file: " << inFile << " (" << s.size() << " bytes)" << std::endl;
+  if(bench == "sa"){
+    benchSA(s, maxt, reps);
+  } else if(bench == "pnsv"){
+    benchPNSV(s, maxt, reps);
+  } else if(bench == "lz"){
+    benchLZ(s, maxt, reps);
+  } else if(bench == "lcp"){
+    benchLCP(s, reps);
+  } else if(bench == "cache"){
+    benchCache(inFile, reps);
+  } else if(bench == "decode"){
+    benchDecode(s, reps);
+  } else if(bench == "extract"){
+    benchExtract(s, reps);
+  } else {
+    print_usage_bench(argv);
+  }
+  return 0;
+}
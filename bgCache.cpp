@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgCache.cpp
+//   files caching arrays computed from a text (suffix array, ...)
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bgCache.hpp"
+
+namespace LZBG {
+
+  static const char CACHE_MAGIC[8] = { 'L', 'Z', 'B', 'G', 'C', 'A', 'C', 'H' };
+
+  CacheHeader cacheHeader(const Text & s, uint32_t width,
+			  const char * content, const char * backend){
+    CacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CACHE_MAGIC, sizeof(h.magic));
+    h.version = CACHE_VERSION;
+    h.width = width;
+    h.n = s.size();
+    h.hash = s.hash();
+    strncpy(h.content, content, sizeof(h.content) - 1);
+    strncpy(h.backend, backend, sizeof(h.backend) - 1);
+    return h;
+  }
+
+  int openCache(const std::string & fileName, const CacheHeader & h, int64_t size){
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return -1;
+    CacheHeader g;
+    struct stat st;
+    if(fstat(fd, &st) || size_t(st.st_size) < sizeof(h)
+       || (size >= 0 && size_t(st.st_size) != sizeof(h) + size)
+       || pread(fd, &g, sizeof(g), 0) != ssize_t(sizeof(g))
+       || memcmp(&g, &h, sizeof(h)) != 0){
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  size_t cacheSize(int fd){
+    struct stat st;
+    return fstat(fd, &st) ? 0 : st.st_size - sizeof(CacheHeader);
+  }
+
+  bool readCache(int fd, void * data, size_t size){
+    return readCache(fd, &data, &size, 1);
+  }
+
+  bool readCache(int fd, void * const * data, const size_t * size, int k){
+    off_t off = sizeof(CacheHeader);
+    bool ok = true;
+    for(int j = 0; j < k && ok; j++){
+      char * p = static_cast<char *>(data[j]);
+      size_t left = size[j];
+      while(left > 0){
+	const ssize_t r = pread(fd, p, left, off);
+	if(r <= 0) break;
+	p += r; off += r; left -= r;
+      }
+      ok = (left == 0);
+    }
+    close(fd);
+    return ok;
+  }
+
+  void * mapCache(int fd, size_t size){
+    void * m = mmap(0, sizeof(CacheHeader) + size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED) return 0;
+    madvise(m, sizeof(CacheHeader) + size, MADV_WILLNEED);
+    return static_cast<char *>(m) + sizeof(CacheHeader);
+  }
+
+  bool writeCache(const std::string & fileName, const CacheHeader & h,
+		  const void * data, size_t size){
+    return writeCache(fileName, h, &data, &size, 1);
+  }
+
+  bool writeCache(const std::string & fileName, const CacheHeader & h,
+		  const void * const * data, const size_t * size, int k){
+    std::ostringstream tmp;
+    tmp << fileName << ".tmp" << getpid();
+    std::ofstream ofs(tmp.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    for(int j = 0; j < k; j++) ofs.write(static_cast<const char *>(data[j]), size[j]);
+    ofs.close();
+    if(!ofs || rename(tmp.str().c_str(), fileName.c_str()) != 0){
+      std::cerr << "failed to write file: " << fileName << std::endl;
+      unlink(tmp.str().c_str());
+      return false;
+    }
+    return true;
+  }
+
+  ////////////////////////////////////////////////////////////
+  // compressed suffix array
+  // layout: n, SA_SAMPLE, count[256], ISA samples, length[256]
+  // (8 bytes each), the differences of Psi for each character,
+  // and the textHash of all of the above.
+  ////////////////////////////////////////////////////////////
+  static void putInt(std::string & out, uint64_t x){
+    for(int k = 0; k < 8; k++) out.push_back(static_cast<char>(x >> (8 * k)));
+  }
+
+  static uint64_t getInt(const uint8_t * p){
+    uint64_t x = 0;
+    for(int k = 0; k < 8; k++) x |= uint64_t(p[k]) << (8 * k);
+    return x;
+  }
+
+  static void putVarint(std::string & out, uint64_t x){
+    while(x >= 0x80){
+      out.push_back(static_cast<char>(x | 0x80));
+      x >>= 7;
+    }
+    out.push_back(static_cast<char>(x));
+  }
+
+  static bool getVarint(const uint8_t *& p, const uint8_t * end, uint64_t & x){
+    x = 0;
+    for(int shift = 0; shift < 64 && p < end; shift += 7){
+      const uint8_t c = *p++;
+      x |= uint64_t(c & 0x7f) << shift;
+      if(!(c & 0x80)) return true;
+    }
+    return false;
+  }
+
+  // difference d of Psi in bucket c: runs of 1s are counted in run[c]
+  static inline void putDiff(std::string & out, int64_t & run, uint64_t d){
+    if(d == 1){ run++; return; }
+    if(run > 0) putVarint(out, uint64_t(run) << 1 | 1);
+    run = 0;
+    putVarint(out, d << 1);
+  }
+
+  template<class Index>
+  void saCompress(const char * s, const Index * sa, typename IndexValue<Index>::type n,
+		  std::string & out){
+    typedef typename IndexValue<Index>::type V;
+    const uint8_t * T = reinterpret_cast<const uint8_t *>(s);
+    int64_t count[256] = { 0 }, run[256] = { 0 };
+    V last[256] = { 0 };
+    std::vector<std::string> psi(256);
+    std::vector<int64_t> sample((n + SA_SAMPLE - 1) / SA_SAMPLE);
+    for(V i = 0; i < n; i++) count[T[i]]++;
+    // suffix n-1 is the first row of its bucket (no Psi, stored as 0)
+    if(n > 0) putDiff(psi[T[n-1]], run[T[n-1]], 0);
+    // the rows of bucket c are those of the suffixes c T[SA[j]..] in order of j
+    for(V j = 0; j < n; j++){
+      const V k = sa[j];
+      if(k % SA_SAMPLE == 0) sample[k / SA_SAMPLE] = j;
+      if(k == 0) continue;
+      const uint8_t c = T[k - 1];
+      putDiff(psi[c], run[c], j - last[c]);
+      last[c] = j;
+    }
+    out.clear();
+    putInt(out, n);
+    putInt(out, SA_SAMPLE);
+    for(int c = 0; c < 256; c++) putInt(out, count[c]);
+    for(size_t m = 0; m < sample.size(); m++) putInt(out, sample[m]);
+    for(int c = 0; c < 256; c++){
+      if(run[c] > 0) putVarint(psi[c], uint64_t(run[c]) << 1 | 1);
+      putInt(out, psi[c].size());
+    }
+    for(int c = 0; c < 256; c++){
+      out.append(psi[c]);
+      std::string().swap(psi[c]);
+    }
+    putInt(out, textHash(out.data(), out.size()));
+  }
+
+  template<class Index>
+  bool saDecompress(const char * in, size_t size, typename IndexValue<Index>::type n,
+		    Index * sa){
+    typedef typename IndexValue<Index>::type V;
+    const uint8_t * p = reinterpret_cast<const uint8_t *>(in), * end = p + size;
+    const size_t M = (n + SA_SAMPLE - 1) / SA_SAMPLE;
+    if(size < 8 * (3 + 256 + 256 + M) || V(getInt(p)) != n || getInt(p + 8) != uint64_t(SA_SAMPLE))
+      return false;
+    end -= 8;
+    if(getInt(end) != textHash(in, size - 8)) return false;
+    p += 16;
+    V start[257];
+    start[0] = 0;
+    for(int c = 0; c < 256; c++, p += 8) start[c + 1] = start[c] + V(getInt(p));
+    if(start[256] != n) return false;
+    std::vector<V> sample(M);
+    for(size_t m = 0; m < M; m++, p += 8){
+      sample[m] = V(getInt(p));
+      if(sample[m] < 0 || sample[m] >= n) return false;
+    }
+    const uint8_t * stream[257];
+    stream[0] = p + 8 * 256;
+    for(int c = 0; c < 256; c++, p += 8){
+      stream[c + 1] = stream[c] + getInt(p);
+      if(stream[c + 1] < stream[c] || stream[c + 1] > end) return false;
+    }
+    if(stream[256] != end) return false;
+
+    // Psi in row[2 * i], and SA in row[2 * i + 1], so that a step of
+    // the chains below reads and writes one cache line
+    std::vector<Index> row(2 * size_t(n));
+    bool ok = true;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(&&:ok)
+#endif
+    for(int c = 0; c < 256; c++){
+      const uint8_t * q = stream[c];
+      V i = start[c], x = 0;
+      uint64_t token;
+      while(i < start[c + 1] && getVarint(q, stream[c + 1], token)){
+	const V r = (token & 1) ? V(token >> 1) : 1;
+	if(r > start[c + 1] - i){ ok = false; break; }
+	for(V k = 0; k < r; k++){
+	  x += (token & 1) ? 1 : V(token >> 1);
+	  if(x < 0 || x >= n){ ok = false; break; }
+	  row[2 * i++] = x;
+	}
+	if(!ok) break;
+      }
+      if(i != start[c + 1] || q != stream[c + 1]) ok = false;
+    }
+    if(!ok) return false;
+
+    // follow Psi from the sampled rows, LANES chains at a time
+    const int LANES = 16;
+    const V groups = (V(M) + LANES - 1) / LANES;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for(V g = 0; g < groups; g++){
+      V r[LANES], k[LANES], e[LANES];
+      int lanes = 0;
+      for(V m = g * LANES; m < V(M) && lanes < LANES; m++, lanes++){
+	r[lanes] = sample[m];
+	k[lanes] = m * SA_SAMPLE;
+	e[lanes] = std::min<V>(k[lanes] + SA_SAMPLE, n);
+      }
+      if(lanes == LANES && e[LANES - 1] - k[LANES - 1] == SA_SAMPLE){
+	for(V t = 0; t < SA_SAMPLE; t++){
+	  for(int l = 0; l < LANES; l++){
+	    row[2 * r[l] + 1] = k[l]++;
+	    r[l] = row[2 * r[l]];
+	  }
+	}
+      } else {
+	for(int l = 0; l < lanes; l++){
+	  for(; k[l] < e[l]; k[l]++){
+	    row[2 * r[l] + 1] = k[l];
+	    r[l] = row[2 * r[l]];
+	  }
+	}
+      }
+    }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(V i = 0; i < n; i++) sa[i] = row[2 * i + 1];
+    return true;
+  }
+
+#define LZBG_INSTANTIATE(Index)						\
+  template void saCompress(const char *, const Index *, IndexValue<Index>::type, std::string &); \
+  template bool saDecompress(const char *, size_t, IndexValue<Index>::type, Index *);
+
+  LZBG_INSTANTIATE(int32_t)
+  LZBG_INSTANTIATE(uint40_t)
+  LZBG_INSTANTIATE(int64_t)
+}
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgCache.hpp
+//   files caching arrays computed from a text (suffix array, ...)
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+// file format: a header of 64 bytes, followed by the array.
+// a cache is used only if all fields of the header are as expected,
+// so that a cache of another text, index width or program is never used,
+// and the file is as long as expected. the text is identified by its
+// length and hash, not by the time stamps of the files.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_CACHE_HPP__
+#define __LZBG_CACHE_HPP__
+
+#include <stdint.h>
+#include <string>
+#include "bgCommon.hpp"
+
+namespace LZBG {
+
+  static const uint32_t CACHE_VERSION = 1;
+
+  struct CacheHeader {
+    char magic[8];      // "LZBGCACH"
+    uint32_t version;   // CACHE_VERSION
+    uint32_t width;     // bytes per index
+    uint64_t n;         // length of the text
+    uint64_t hash;      // textHash of the text
+    char content[16];   // what is stored, e.g. "sa"
+    char backend[16];   // how it was computed, e.g. "divsufsort"
+  };
+
+  // expected header of a cache of content for text s
+  CacheHeader cacheHeader(const Text & s, uint32_t width,
+			  const char * content, const char * backend);
+
+  // open cache fileName, and check that its header equals h
+  // and that size bytes follow it (any number if size < 0).
+  // return a file descriptor or -1.
+  int openCache(const std::string & fileName, const CacheHeader & h, int64_t size);
+
+  // number of bytes following the header
+  size_t cacheSize(int fd);
+
+  // read size bytes following the header into data. closes fd.
+  bool readCache(int fd, void * data, size_t size);
+
+  // read size[j] bytes into data[j] for j = 0..k-1, in this order. closes fd.
+  bool readCache(int fd, void * const * data, const size_t * size, int k);
+
+  // map the file read-only and shared, and return the address of the
+  // data following the header, or 0. closes fd.
+  void * mapCache(int fd, size_t size);
+
+  // write header h and size bytes of data to fileName.
+  // the data is written to a temporary file that is renamed to fileName
+  // when complete, so that a partial file is never seen by other processes.
+  bool writeCache(const std::string & fileName, const CacheHeader & h,
+		  const void * data, size_t size);
+
+  // write header h and size[j] bytes of data[j] for j = 0..k-1
+  bool writeCache(const std::string & fileName, const CacheHeader & h,
+		  const void * const * data, const size_t * size, int k);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // compressed suffix array (content "sa-psi"):
+  // Psi[i] = ISA[SA[i] + 1] is increasing in the rows of each character, and
+  // is stored as differences (varints, with runs of 1s as one varint),
+  // together with the rows ISA[k * SA_SAMPLE] of every SA_SAMPLE-th suffix,
+  // and a hash of the data.
+  // SA is recovered by following Psi from the sampled rows, several chains
+  // at a time (and in parallel with OpenMP), with 2*n temporary indices.
+  ////////////////////////////////////////////////////////////////////////////////
+  static const int64_t SA_SAMPLE = 1 << 12;
+
+  template<class Index>
+  void saCompress(const char * s, const Index * sa, typename IndexValue<Index>::type n,
+		  std::string & out);
+
+  // return false if in[0..size-1] is not a compressed suffix array of length n
+  template<class Index>
+  bool saDecompress(const char * in, size_t size, typename IndexValue<Index>::type n,
+		    Index * sa);
+};
+#endif//__LZBG_CACHE_HPP__
@@ -17,10 +17,21 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "bgCommon.hpp"
+#include "bgCache.hpp"
+#include "bgLCP.hpp"
 #include "divsufsort.h"
 
 #define PSV(i) pnsv[(i << 1)]
@@ -29,55 +40,129 @@
 #define LPS(i) lpspo[(i << 1)]
 #define PREVOCC(i) lpspo[(i << 1)+1]
 
+#if defined(LZBG_64BIT)
+#define SA_EXT ".sa64"
+#define PNSV_EXT ".pnsv64"
+#define SA_BACKEND "divsufsort64"
+#elif defined(LZBG_40BIT)
+#define SA_EXT ".sa40"
+#define PNSV_EXT ".pnsv40"
+#define SA_BACKEND "divsufsort64"
+#else
+#define SA_EXT ".sa"
+#define PNSV_EXT ".pnsv"
+#define SA_BACKEND "divsufsort"
+#endif
+
 namespace LZBG {
 
   bool checkResult = false;
+  std::string outFile;
+  bool compressSA = false;
+
+  static std::string inFile;      // input file (-f)
+  static bool useSAcache = false; // -x
+  static bool usePNSVcache = false; // -p
 
   ////////////////////////////////////////////////////////////
   // parse options and read/construct string & suffix array
   ////////////////////////////////////////////////////////////
   
-  int * Init(int argc, char * argv[], std::string & s, unsigned int f, int * sa){
+  saidx_t * Init(int argc, char * argv[], Text & s, unsigned int f, saidx_t * sa){
     int ch;
-    std::string inFile, saFile;
-    bool useSAcache = false;
-    while ((ch = getopt(argc, argv, "f:xgh")) != -1) {
+    std::string inMode = "mmap";
+    while ((ch = getopt(argc, argv, "f:m:xzpgo:t:h")) != -1) {
       switch (ch) {
       case 'f':
 	inFile = optarg;
 	break;
+      case 'm':
+	inMode = optarg;
+	break;
+      case 't':
+	setThreads(atoi(optarg));
+	break;
       case 'x':
 	useSAcache = true;
 	break;
+      case 'z':
+	compressSA = true;
+	break;
+      case 'p':
+	usePNSVcache = true;
+	break;
       case 'g':
 	checkResult = true;
 	break;
+      case 'o':
+	outFile = optarg;
+	break;
       default:
 	print_usage(argc, argv);
 	exit(0);
       }
     }
-    if(inFile.empty()){ print_usage(argc, argv); exit(0); }
+    if(inFile.empty() || (inMode != "mmap" && inMode != "populate" &&
+			  inMode != "seq" && inMode != "read")){
+      print_usage(argc, argv);
+      exit(0);
+    }
     
     argc -= optind;
     argv += optind;
     ////////////////////////////////////////////////////////////
     
-    stringFromFile(inFile, s);
+    double t = gettime();
+    const unsigned int mf = (inMode == "populate") ? Text::POPULATE :
+      (inMode == "seq") ? Text::SEQUENTIAL : 0;
+    if(inMode == "read" || !s.mapFile(inFile, mf)) s.readFile(inFile);
+    if(s.size() > static_cast<size_t>(IndexLimit<saidx_t>::max)){
+      std::cerr << "ERROR: The file size is too big for " << sizeof(saidx_t) * 8
+		<< " bit indices. Cannot process." << std::endl;
+      exit(1);
+    }
+    std::cout << "Time for input: " << gettime() - t << std::endl;
+    if(f & LAZY_SA){
+      if(sa == 0 && !(f & READONLY_SA)) sa = new saidx_t[(f & DOUBLE_SA) ? s.size() * 2 : s.size()];
+      return(sa);
+    }
+    return(loadSA(s, sa, f));
+  }
+
+  saidx_t * loadSA(const Text & s, saidx_t * sa, unsigned int f){
+    double t = gettime();
     if(useSAcache){
       sa = saFromFile(s, inFile, sa, f);
     } else {
       sa = suffixArray(s, sa, f);
     }
+    std::cout << "Time for sa: " << gettime() - t << std::endl;
     return(sa);
   }
 
+  void setThreads(int threads){
+#ifdef _OPENMP
+    if(threads > 0) omp_set_num_threads(threads);
+#else
+    if(threads > 1)
+      std::cerr << "WARNING: compiled without OpenMP, running with 1 thread" << std::endl;
+#endif
+  }
+
   void print_usage(int argc, char * argv []){
     std::cout << "Usage  : " << argv[0] << " [options]" << std::endl
 	      << "Options: " << std::endl
 	      << "  -f iFile : file to process" << std::endl
-	      << "  -x       : use iFile + '.sa' for suffix array cache" << std::endl
-	      << "  -g       : check if resulting factorization produces input string" << std::endl;
+	      << "  -m mode  : how iFile is read: mmap (default), populate (map and" << std::endl
+	      << "             read all pages at once), seq (map for sequential access)," << std::endl
+	      << "             read (copy into memory)" << std::endl
+	      << "  -x       : use iFile + '" << SA_EXT << "' for suffix array cache" << std::endl
+	      << "  -z       : compress the suffix array cache (with -x)" << std::endl
+	      << "  -p       : use iFile + '.<program>" << PNSV_EXT << "' for PSV/NSV cache" << std::endl
+	      << "             (BGS, BGL, BGT and iBGS, iBGL, iBGT; ignored by OG, iOG)" << std::endl
+	      << "  -g       : check if resulting factorization produces input string" << std::endl
+	      << "  -o oFile : write the factorization to oFile (see lzFile.hpp)" << std::endl
+	      << "  -t num   : number of threads (requires OpenMP, default: all cores)" << std::endl;
     return;
   }
 
@@ -97,303 +182,988 @@ namespace LZBG {
       return;
     }
     fileSize = st.st_size;
-    if(fileSize != static_cast<size_t>(static_cast<int>(fileSize))){
-      std::cerr << "ERROR: The file size is too big to fit in int. Cannot process." << std::endl;
+    if(fileSize > static_cast<size_t>(IndexLimit<saidx_t>::max)){
+      std::cerr << "ERROR: The file size is too big for " << sizeof(saidx_t) * 8
+		<< " bit indices. Cannot process." << std::endl;
       return;
     }
     s.resize(fileSize);
     ifs.read(reinterpret_cast<char*>(&s[0]), fileSize);
   }
 
+  ////////////////////////////////////////////////////////////
+  // input text mapped from or read from a file
+  ////////////////////////////////////////////////////////////
+  bool Text::operator==(const std::string & t) const {
+    return n == t.size() && memcmp(p, t.data(), n) == 0;
+  }
+
+  bool Text::mapFile(const std::string & fileName, unsigned int flags){
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size == 0){
+      close(fd);
+      return false;
+    }
+    int mflags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if(flags & POPULATE) mflags |= MAP_POPULATE;
+#endif
+    void * m = mmap(0, st.st_size, PROT_READ, mflags, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED) return false;
+    // without POPULATE, pages are read ahead while the suffix array is set up
+    madvise(m, st.st_size, (flags & SEQUENTIAL) ? MADV_SEQUENTIAL : MADV_WILLNEED);
+    release();
+    map = m;
+    p = static_cast<const char *>(m);
+    n = st.st_size;
+    return true;
+  }
+
+  void Text::readFile(const std::string & fileName){
+    release();
+    stringFromFile(fileName, str);
+    p = str.data();
+    n = str.size();
+  }
 
-  int * suffixArray(const std::string & s, int * sa, unsigned int f){
+  uint64_t Text::hash() const {
+    if(!hashed) hashValue = textHash(p, n);
+    hashed = true;
+    return hashValue;
+  }
+
+  void Text::release(){
+    if(map) munmap(map, n);
+    map = 0;
+    hashed = false;
+    std::string().swap(str);
+    p = "";
+    n = 0;
+  }
+
+  saidx_t * suffixArray(const Text & s, saidx_t * sa, unsigned int f){
+    size_t sasize = (f & DOUBLE_SA) ? s.size() * 2 : s.size();
     if(sa == 0){
-      size_t sasize = (f & DOUBLE_SA) ? s.size() * 2 : s.size();
-      sa = new int[sasize];
+      sa = new saidx_t[sasize];
     }
     std::cerr << "Building suffix array..." << std::flush;
-    divsufsort(reinterpret_cast<const unsigned char *>(s.c_str()), sa, s.size());
+    divsufsort(reinterpret_cast<const unsigned char *>(s.data()), sa, s.size(), sasize);
     std::cerr << "done" << std::endl;
     return (sa);
   }
 
-  int * saFromFile(const std::string & s, const std::string & fname, int * sa, unsigned int f){
+  int divsufsort(const unsigned char * T, int32_t * sa, int32_t n, size_t, void * bucket){
+    if(bucket) return ::divsufsort_bucket(T, sa, n, static_cast<int32_t *>(bucket));
+    return ::divsufsort(T, sa, n);
+  }
+
+  int divsufsort(const unsigned char * T, uint40_t * sa, int64_t n, size_t sasize, void * bucket){
+    const bool inPlace = (sasize * sizeof(uint40_t) >= n * sizeof(int64_t));
+    int64_t * sa64 = inPlace ? reinterpret_cast<int64_t *>(sa) : new int64_t[n];
+    int err = divsufsort(T, sa64, n, n, bucket);
+    // packing from left to right never overwrites values not yet read
+    for(int64_t i = 0; i < n; i++) sa[i] = sa64[i];
+    if(!inPlace) delete [] sa64;
+    return err;
+  }
+
+  int divsufsort(const unsigned char * T, int64_t * sa, int64_t n, size_t, void * bucket){
+    if(bucket) return ::divsufsort64_bucket(T, sa, n, static_cast<int64_t *>(bucket));
+    return ::divsufsort64(T, sa, n);
+  }
+
+  ////////////////////////////////////////////////////////////
+  // the suffix array cache is written on a background thread while
+  // the factorization proceeds, and the program waits for it at exit.
+  // the thread writes a copy of the suffix array (or the compressed
+  // one), unless it is not modified by the caller (READONLY_SA).
+  ////////////////////////////////////////////////////////////
+  struct SAWrite {
+    std::string fileName;
+    CacheHeader h;
+    const char * data;
+    size_t size;
+    char * copy;      // freed after writing
+    std::string z;    // compressed suffix array
+  };
+  static pthread_t saWriter;
+  static bool saWriting = false;
+
+  static void * writeSA(void * arg){
+    SAWrite * w = static_cast<SAWrite *>(arg);
+    writeCache(w->fileName, w->h, w->data, w->size);
+    delete [] w->copy;
+    delete w;
+    return 0;
+  }
+
+  static void waitSA(){
+    if(saWriting) pthread_join(saWriter, 0);
+    saWriting = false;
+  }
+
+  static void writeSAInBackground(SAWrite * w){
+    static bool registered = false;
+    waitSA();
+    if(pthread_create(&saWriter, 0, writeSA, w) != 0){
+      writeSA(w);
+      return;
+    }
+    saWriting = true;
+    if(!registered) atexit(waitSA);
+    registered = true;
+  }
+
+  saidx_t * saFromFile(const Text & s, const std::string & fname, saidx_t * sa, unsigned int f){
     ////////////////////////////////////////////////////////////
-    // check if suffix array file if it exists
+    // check if suffix array file exists and is valid for s
     ////////////////////////////////////////////////////////////
-    bool remake = false;
-    struct stat st1, st2;
-    std::string safname = fname + ".sa";
-    if(stat(fname.c_str(), &st1)) remake = true;
-    if(stat(safname.c_str(), &st2)) remake = true;
-    if(st1.st_mtime >= st2.st_mtime){
-      remake = true;
-    }
-    std::ifstream sfs(safname.c_str(), std::ios::in | std::ios::binary);
-    if(!sfs){
-      remake = true;
-    } else if(sfs){
-      const size_t fileSize = st2.st_size;
-      if (fileSize != sizeof(int) * s.size()){
-	remake = true;
-      } else {
-	std::cerr << "reading suffix array from: " << safname << std::flush;
-	if(sa == 0){
-	  size_t sasize = (f & DOUBLE_SA) ? (fileSize / sizeof(int)) * 2 : fileSize / sizeof(int);
-	  sa = new int[sasize];
-	}
-	sfs.read(reinterpret_cast<char*>(sa), fileSize);
+    const std::string safname = fname + SA_EXT;
+    const size_t size = sizeof(saidx_t) * s.size();
+    const CacheHeader h = cacheHeader(s, sizeof(saidx_t), "sa", SA_BACKEND);
+    int fd = openCache(safname, h, size);
+    if(fd >= 0 && sa == 0 && (f & READONLY_SA)){
+      // pages are shared with other processes, and read while computing
+      void * m = mapCache(fd, size);
+      if(m){
+	std::cerr << "mapped suffix array from: " << safname << std::endl;
+	return static_cast<saidx_t *>(m);
+      }
+      fd = openCache(safname, h, size);
+    }
+    if(fd >= 0){
+      std::cerr << "reading suffix array from: " << safname << std::flush;
+      const bool alloc = (sa == 0);
+      if(alloc) sa = new saidx_t[(f & DOUBLE_SA) ? s.size() * 2 : s.size()];
+      if(readCache(fd, sa, size)){
+	std::cerr << " ...done" << std::endl;
+	return(sa);
+      }
+      std::cerr << " ...failed" << std::endl;
+      if(alloc){ delete [] sa; sa = 0; }
+    }
+    const CacheHeader hz = cacheHeader(s, sizeof(saidx_t), "sa-psi", SA_BACKEND);
+    if((fd = openCache(safname, hz, -1)) >= 0){
+      std::cerr << "decompressing suffix array from: " << safname << std::flush;
+      std::string z(cacheSize(fd), '\0');
+      const bool alloc = (sa == 0);
+      if(alloc) sa = new saidx_t[(f & DOUBLE_SA) ? s.size() * 2 : s.size()];
+      if(readCache(fd, &z[0], z.size()) && saDecompress(z.data(), z.size(), savalue_t(s.size()), sa)){
 	std::cerr << " ...done" << std::endl;
+	return(sa);
       }
+      std::cerr << " ...failed" << std::endl;
+      if(alloc){ delete [] sa; sa = 0; }
     }
     ////////////////////////////////////////////////////////////
     // construct suffix array and cache it to file
     ////////////////////////////////////////////////////////////
-    if(remake){
-      std::cerr << "suffix array file: " << safname << " not found, invalid or out of date." << std::endl;
-      sa = suffixArray(s, sa, f);
-      std::cerr << "Saving suffix array to file..." << std::flush;
-      std::ofstream ofs(safname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-      ofs.write(reinterpret_cast<const char*>(sa), sizeof(int) * s.size());
-      std::cerr << "done" << std::endl;
+    std::cerr << "suffix array file: " << safname << " not found, invalid or out of date." << std::endl;
+    sa = suffixArray(s, sa, f);
+    SAWrite * w = new SAWrite;
+    w->fileName = safname;
+    w->copy = 0;
+    if(compressSA){
+      saCompress(s.data(), sa, savalue_t(s.size()), w->z);
+      w->h = hz;
+      w->data = w->z.data();
+      w->size = w->z.size();
+    } else {
+      w->h = h;
+      w->data = reinterpret_cast<const char *>(sa);
+      w->size = size;
+      if(!(f & READONLY_SA)){
+	w->copy = new char[size];
+	memcpy(w->copy, sa, size);
+	w->data = w->copy;
+      }
     }
+    std::cerr << "Saving suffix array to file in the background" << std::endl;
+    writeSAInBackground(w);
     return(sa);
   }
 
-  inline int naiveLCP(const char * const x, int i, int j, int n){
-    int l = 0;
-    while(j < n && x[i++] == x[j++]){ l++; }
-    return l;
+  int openSA(const Text & s, const std::string & fname){
+    const std::string safname = fname + SA_EXT;
+    const size_t size = sizeof(saidx_t) * s.size();
+    const CacheHeader h = cacheHeader(s, sizeof(saidx_t), "sa", SA_BACKEND);
+    int fd = openCache(safname, h, size);
+    if(fd >= 0) return fd;
+    std::cerr << "suffix array file: " << safname << " not found, invalid or out of date." << std::endl;
+    saidx_t * sa = suffixArray(s, 0, 0);
+    std::cerr << "saving suffix array to file: " << safname << std::endl;
+    const bool ok = writeCache(safname, h, sa, size);
+    delete [] sa;
+    if(!ok || (fd = openCache(safname, h, size)) < 0)
+      std::cerr << "failed to write suffix array file: " << safname << std::endl;
+    return fd;
   }
-  
-  void lzFromTOPNSV(const std::string & s, 
-		    const int * psv,
-		    const int * nsv,
-		    std::vector<std::pair<int,int> > & lz){
-    
-    ////////////////////////////////////////////////////////////
-    // main LZ factorization
-    ////////////////////////////////////////////////////////////
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      int prevPos = psv[p];
-      int lpf = (psv[p] < 0) ? 0 : naiveLCP(s.c_str(), psv[p], p, s.size());
-      int nlen = (nsv[p] < 0) ? 0 : naiveLCP(s.c_str(), nsv[p], p, s.size());
-      if(nlen > lpf){ lpf = nlen; prevPos = nsv[p]; }
-      if(lpf > 0){
-	lz.push_back(std::make_pair(lpf,prevPos));
-	p += lpf;
+
+  ////////////////////////////////////////////////////////////
+  // cache of the arrays computed by a program (-p)
+  ////////////////////////////////////////////////////////////
+  bool loadArrays(const Text & s, const char * name, saidx_t * const * a, int k){
+    if(!usePNSVcache) return false;
+    const std::string fname = inFile + "." + name + PNSV_EXT;
+    const size_t size = sizeof(saidx_t) * s.size();
+    const int fd = openCache(fname, cacheHeader(s, sizeof(saidx_t), name, SA_BACKEND), k * size);
+    if(fd < 0){
+      std::cerr << "PSV/NSV file: " << fname << " not found, invalid or out of date." << std::endl;
+      return false;
+    }
+    std::vector<void *> data(a, a + k);
+    std::vector<size_t> sizes(k, size);
+    if(!readCache(fd, &data[0], &sizes[0], k)) return false;
+    std::cerr << "read PSV/NSV from: " << fname << std::endl;
+    return true;
+  }
+
+  void saveArrays(const Text & s, const char * name, const saidx_t * const * a, int k){
+    if(!usePNSVcache) return;
+    const std::string fname = inFile + "." + name + PNSV_EXT;
+    std::vector<const void *> data(a, a + k);
+    std::vector<size_t> sizes(k, sizeof(saidx_t) * s.size());
+    std::cerr << "Saving PSV/NSV to file..." << std::flush;
+    if(writeCache(fname, cacheHeader(s, sizeof(saidx_t), name, SA_BACKEND), &data[0], &sizes[0], k))
+      std::cerr << "done" << std::endl;
+  }
+
+  ////////////////////////////////////////////////////////////
+  // PSV, NSV in lex order in parallel (all nearest smaller values)
+  // psv[i*st], nsv[i*st] are set to lex ranks, or to text positions
+  // if values is true. st = 2 for the interleaving version.
+  // the array is split into one block per thread:
+  //  1. peak elimination within each block. the elements left
+  //     without PSV (NSV) are the prefix (suffix) minima of the block,
+  //     which are linked by NSV (PSV) and end at the block minimum.
+  //  2. for each block, the unresolved PSVs are found in the suffix
+  //     minima of the blocks to the left, skipping blocks whose minimum
+  //     is larger (and NSVs symmetrically). the prefix minima are
+  //     decreasing, so the search position only moves to the left.
+  //     links of a block minimum are never followed, since they are
+  //     updated concurrently.
+  // the result is the same as the sequential versions.
+  // return false (and do nothing) if a single thread would be used.
+  ////////////////////////////////////////////////////////////
+  template<class Index>
+  static bool pnsvParallel(const Index * sa, typename IndexValue<Index>::type n,
+			   Index * psv, Index * nsv,
+			   typename IndexValue<Index>::type st, bool values){
+#ifdef _OPENMP
+    typedef typename IndexValue<Index>::type V;
+    const V minBlock = 1 << 16;
+    V nb = omp_get_max_threads();
+    if(nb > n / minBlock) nb = n / minBlock;
+    if(nb < 2) return false;
+    std::vector<V> minpos(nb);
+#define BLOCK_BEG(b) ((b) * (n / nb))
+#define BLOCK_END(b) ((b) + 1 == nb ? n : ((b) + 1) * (n / nb))
+
+#pragma omp parallel for num_threads(nb) schedule(static, 1)
+    for(V b = 0; b < nb; b++){
+      const V lo = BLOCK_BEG(b), hi = BLOCK_END(b);
+      V m = lo;
+      for(V i = lo; i < hi; i++){
+	nsv[i*st] = -1;
+	V p = i - 1;
+	while(p >= lo && sa[p] > sa[i]){ // p is peak
+	  nsv[p*st] = i;
+	  p = psv[p*st];
+	}
+	psv[i*st] = (p >= lo) ? p : V(-1);
+	if(sa[i] < sa[m]) m = i;
+      }
+      minpos[b] = m;
+    }
+
+#pragma omp parallel for num_threads(nb) schedule(static, 1)
+    for(V b = 0; b < nb; b++){
+      // PSV of prefix minima, from the left (decreasing)
+      V c = b - 1, q = (c >= 0) ? BLOCK_END(c) - 1 : 0;
+      for(V x = BLOCK_BEG(b); ; x = nsv[x*st]){
+	const V v = sa[x];
+	while(c >= 0 && sa[minpos[c]] > v){ c--; if(c >= 0) q = BLOCK_END(c) - 1; }
+	if(c >= 0){
+	  while(sa[q] > v) q = psv[q*st];
+	}
+	psv[x*st] = (c >= 0) ? q : V(-1);
+	if(x == minpos[b]) break;
+      }
+      // NSV of suffix minima, from the right (decreasing)
+      c = b + 1; q = (c < nb) ? BLOCK_BEG(c) : 0;
+      for(V y = BLOCK_END(b) - 1; ; y = psv[y*st]){
+	const V v = sa[y];
+	while(c < nb && sa[minpos[c]] > v){ c++; if(c < nb) q = BLOCK_BEG(c); }
+	if(c < nb){
+	  while(sa[q] > v) q = nsv[q*st];
+	}
+	nsv[y*st] = (c < nb) ? q : V(-1);
+	if(y == minpos[b]) break;
+      }
+    }
+#undef BLOCK_BEG
+#undef BLOCK_END
+
+    if(values){
+#pragma omp parallel for num_threads(nb)
+      for(V i = 0; i < n; i++){
+	const V p = psv[i*st], q = nsv[i*st];
+	psv[i*st] = (p < 0) ? V(-1) : V(sa[p]);
+	nsv[i*st] = (q < 0) ? V(-1) : V(sa[q]);
+      }
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  ////////////////////////////////////////////////////////////
+  // PSV, NSV in lex order using stack
+  // the stack is linked through the nsv entries of its elements,
+  // which are not set until they are popped, so that no memory
+  // besides psv, nsv is needed (up to n elements otherwise).
+  ////////////////////////////////////////////////////////////
+  template<class Index>
+  void pnsvStack(const Index * sa, typename IndexValue<Index>::type n,
+		 Index * psv, Index * nsv){
+    typedef typename IndexValue<Index>::type V;
+    if(pnsvParallel(sa, n, psv, nsv, V(1), true)) return;
+    V i, top = -1, t;
+
+    for(i = 0; i < n; i++){
+      const V x = sa[i];
+      while(top >= 0 && sa[top] > x){       // pop while new element is smaller
+	t = top; top = nsv[t]; nsv[t] = x;
+      }
+      psv[i] = (top < 0) ? V(-1) : V(sa[top]);
+      nsv[i] = top; top = i;                // push
+    }
+    while(top >= 0){
+      t = top; top = nsv[t]; nsv[t] = -1;
+    }
+  }
+
+  template<class Index>
+  void pnsvStack(const Index * sa, typename IndexValue<Index>::type n,
+		 Index * pnsv){
+    typedef typename IndexValue<Index>::type V;
+    if(pnsvParallel(sa, n, pnsv, pnsv + 1, V(2), true)) return;
+    V i, top = -1, t;
+
+    for(i = 0; i < n; i++){
+      const V x = sa[i];
+      while(top >= 0 && sa[top] > x){       // pop while new element is smaller
+	t = top; top = NSV(t); NSV(t) = x;
+      }
+      PSV(i) = (top < 0) ? V(-1) : V(sa[top]);
+      NSV(i) = top; top = i;                // push
+    }
+    while(top >= 0){
+      t = top; top = NSV(t); NSV(t) = -1;
+    }
+  }
+
+  ////////////////////////////////////////////////////////////
+  // PSV, NSV in lex order using peak elimination
+  ////////////////////////////////////////////////////////////
+
+  // eliminate peaks to the left of c, until PSV(c) is found
+  template<class Index, class V>
+  static void peakElimLex(V p, V c, Index *psv, Index *nsv, const Index *sa){
+    while(p >= 0 && sa[p] > sa[c]){ // p is peak
+      nsv[p] = c;
+      p = psv[p];
+    }
+    psv[c] = p;
+  }
+
+  template<class Index, class V>
+  static void peakElimLex(V p, V c, Index *pnsv, const Index *sa){
+    while(p >= 0 && sa[p] > sa[c]){ // p is peak
+      NSV(p) = c;
+      p = PSV(p);
+    }
+    PSV(c) = p;
+  }
+
+  template<class Index>
+  void pnsvLex(const Index * sa, typename IndexValue<Index>::type n,
+	       Index * psv, Index * nsv){
+    typedef typename IndexValue<Index>::type V;
+    if(pnsvParallel(sa, n, psv, nsv, V(1), false)) return;
+    V i;
+    for(i = 0; i < n; i++) nsv[i] = -1;
+    psv[0] = -1;
+    for(i = 1; i < n; i++) peakElimLex(i-1, i, psv, nsv, sa);
+  }
+
+  template<class Index>
+  void pnsvLex(const Index * sa, typename IndexValue<Index>::type n,
+	       Index * pnsv){
+    typedef typename IndexValue<Index>::type V;
+    if(pnsvParallel(sa, n, pnsv, pnsv + 1, V(2), false)) return;
+    V i;
+    for(i = 0; i < n; i++) NSV(i) = -1;
+    PSV(0) = -1;
+    for(i = 1; i < n; i++) peakElimLex(i-1, i, pnsv, sa);
+  }
+
+  ////////////////////////////////////////////////////////////
+  // PSV, NSV in text order using peak elimination
+  ////////////////////////////////////////////////////////////
+  // j and i are adjacent in lex order (j = phi[i]):
+  // the larger of the two is a peak, which is eliminated
+  // by linking it to the smaller one, and the next pair is
+  // the smaller one and the next value in the chain of the peak.
+  template<class Index, class V>
+  static void peakElimText(V j, V i, Index * psv, Index * nsv, V bot){
+    for(;;){
+      if(j < i){
+	psv[i] = j;
+	if(nsv[i] == bot) break;
+	i = nsv[i];
       } else {
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
+	nsv[j] = i;
+	if(psv[j] == bot) break;
+	j = psv[j];
       }
     }
-    return;
-    ////////////////////////////////////////////////////////////
   }
 
-  void lzFromTOPNSV(const std::string & s, 
-		    const int * pnsv,
-		    std::vector<std::pair<int,int> > & lz){
-    
-    ////////////////////////////////////////////////////////////
-    // main LZ factorization
-    ////////////////////////////////////////////////////////////
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      int prevPos = PSV(p);
-      int lpf = (PSV(p) < 0) ? 0 : naiveLCP(s.c_str(), PSV(p), p, s.size());
-      int nlen = (NSV(p) < 0) ? 0 : naiveLCP(s.c_str(), NSV(p), p, s.size());
-      if(nlen > lpf){ lpf = nlen; prevPos = NSV(p); }
-      if(lpf > 0){
-	lz.push_back(std::make_pair(lpf,prevPos));
-	p += lpf;
+  template<class Index, class V>
+  static void peakElimText(V j, V i, Index * pnsv, V bot){
+    for(;;){
+      if(j < i){
+	PSV(i) = j;
+	if(NSV(i) == bot) break;
+	i = NSV(i);
       } else {
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
+	NSV(j) = i;
+	if(PSV(j) == bot) break;
+	j = PSV(j);
       }
     }
-    return;
-    ////////////////////////////////////////////////////////////
   }
 
-  void lzFromLOPNSV(const std::string & s, 
-		    const int * sa,
-		    const int * rank,
-		    const int * psv,
-		    const int * nsv,
-		    std::vector<std::pair<int,int> > & lz){
-    
-    ////////////////////////////////////////////////////////////
-    // main LZ factorization
-    ////////////////////////////////////////////////////////////
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      int i = rank[p];
-      int prevPos = sa[psv[i]];
-      int lpf = (psv[i] < 0) ? 0 : naiveLCP(s.c_str(), sa[psv[i]], p, s.size());
-      int nlen = (nsv[i] < 0) ? 0 : naiveLCP(s.c_str(), sa[nsv[i]], p, s.size());
-      if(nlen > lpf){ lpf = nlen; prevPos = sa[nsv[i]]; }
-      if(lpf > 0){
-	lz.push_back(std::make_pair(lpf,prevPos));
-	p += lpf;
+  template<class Index>
+  void pnsvText(const Index * phi, typename IndexValue<Index>::type n,
+		Index * psv, Index * nsv){
+    typedef typename IndexValue<Index>::type V;
+    V i;
+    for(i = 0; i < n; i++) psv[i] = nsv[i] = -1;
+    for(i = 0; i < n; i++) peakElimText(V(phi[i]), i, psv, nsv, V(-1));
+  }
+
+  template<class Index>
+  void pnsvText(const Index * phi, typename IndexValue<Index>::type n,
+		Index * pnsv){
+    typedef typename IndexValue<Index>::type V;
+    V i;
+    for(i = 0; i < 2*n; i++) pnsv[i] = -1;
+    for(i = 0; i < n; i++) peakElimText(V(phi[i]), i, pnsv, V(-1));
+  }
+
+  // phi is computed into psv, and the suffix array is reused for nsv.
+  // the value phi[i] is only needed at step i of the
+  // peak elimination, which only writes psv[j] for j <= i, and only
+  // reads psv[j] for j < i, so that psv can replace phi[i] at step i.
+  template<class Index>
+  void pnsvTextFromSA(Index * sa, typename IndexValue<Index>::type n,
+		      Index * psv){
+    typedef typename IndexValue<Index>::type V;
+    Index * nsv = sa;
+    V i;
+    psv[sa[0]] = sa[n-1];
+    for(i = 1; i < n; i++) psv[sa[i]] = sa[i-1];
+    for(i = 0; i < n; i++) nsv[i] = -1;
+    for(i = 0; i < n; i++){
+      const V j = psv[i];
+      psv[i] = -1;
+      if(j > i){ // psv[j] is not computed yet
+	nsv[j] = i;
       } else {
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
+	peakElimText(j, i, psv, nsv, V(-1));
       }
     }
-    return;
-    ////////////////////////////////////////////////////////////
   }
 
-  void lzFromLOPNSVtp(const std::string & s, 
-		      const int * sa,
-		      const int * rank,
-		      const int * psv,
-		      const int * nsv,
-		      std::vector<std::pair<int,int> > & lz){
-    
-    ////////////////////////////////////////////////////////////
-    // main LZ factorization
-    ////////////////////////////////////////////////////////////
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      int i = rank[p];
-      int prevPos = psv[i];
-      int lpf = (psv[i] < 0) ? 0 : naiveLCP(s.c_str(), psv[i], p, s.size());
-      int nlen = (nsv[i] < 0) ? 0 : naiveLCP(s.c_str(), nsv[i], p, s.size());
-      if(nlen > lpf){ lpf = nlen; prevPos = nsv[i]; }
-      if(lpf > 0){
-	lz.push_back(std::make_pair(lpf,prevPos));
-	p += lpf;
+  ////////////////////////////////////////////////////////////
+  // LPF, PrevOcc in text order (Ohlebusch & Gog)
+  ////////////////////////////////////////////////////////////
+  // i has a previous occurrence j (j < i) with lcp l.
+  // the longer of (lps[i], prevOcc[i]) and (l, j) is kept at i, and the
+  // other pair is passed on to the larger of the two previous occurrences,
+  // which is always smaller than i, so that i is not visited again.
+  template<class Index, class V>
+  static void sop(V i, V l, V j, Index *lps, Index *prevOcc){
+    while(lps[i] != -1){
+      const V li = lps[i], pi = prevOcc[i];
+      if(li < l){
+	lps[i] = l;
+	prevOcc[i] = j;
+	l = li;
+      }
+      if(pi > j){
+	i = pi;
       } else {
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
+	i = j; j = pi;
       }
     }
-    return;
-    ////////////////////////////////////////////////////////////
+    lps[i] = l;
+    prevOcc[i] = j;
   }
 
-  void lzFromLOPNSV(const std::string & s, 
-		    const int * sa,
-		    const int * rank,
-		    const int * pnsv,
-		    std::vector<std::pair<int,int> > & lz){
-    
-    ////////////////////////////////////////////////////////////
-    // main LZ factorization
-    ////////////////////////////////////////////////////////////
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      int i = rank[p];
-      int prevPos = sa[PSV(i)];
-      int lpf = (PSV(i) < 0) ? 0 : naiveLCP(s.c_str(), sa[PSV(i)], p, s.size());
-      int nlen = (NSV(i) < 0) ? 0 : naiveLCP(s.c_str(), sa[NSV(i)], p, s.size());
-      if(nlen > lpf){ lpf = nlen; prevPos = sa[NSV(i)]; }
-      if(lpf > 0){
-	lz.push_back(std::make_pair(lpf,prevPos));
-	p += lpf;
+  template<class Index, class V>
+  static void sop(V i, V l, V j, Index *lpspo){
+    while(LPS(i) != -1){
+      const V li = LPS(i), pi = PREVOCC(i);
+      if(li < l){
+	LPS(i) = l;
+	PREVOCC(i) = j;
+	l = li;
+      }
+      if(pi > j){
+	i = pi;
       } else {
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
+	i = j; j = pi;
       }
     }
-    return;
-    ////////////////////////////////////////////////////////////
+    LPS(i) = l;
+    PREVOCC(i) = j;
   }
 
-  void lzFromLOPNSVtp(const std::string & s, 
-		      const int * sa,
-		      const int * rank,
-		      const int * pnsv,
-		      std::vector<std::pair<int,int> > & lz){
-    
-    ////////////////////////////////////////////////////////////
-    // main LZ factorization
-    ////////////////////////////////////////////////////////////
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      int i = rank[p];
-      int prevPos = PSV(i);
-      int lpf = (PSV(i) < 0) ? 0 : naiveLCP(s.c_str(), PSV(i), p, s.size());
-      int nlen = (NSV(i) < 0) ? 0 : naiveLCP(s.c_str(), NSV(i), p, s.size());
-      if(nlen > lpf){ lpf = nlen; prevPos = NSV(i); }
+  template<class Index>
+  void lpfPrevOcc(const char * x, typename IndexValue<Index>::type n,
+		  const Index * phi, Index * lps, Index * prevOcc){
+    typedef typename IndexValue<Index>::type V;
+    V i, l = 0;
+    for(i = 0; i < n; i++) lps[i] = -1;
+    for(i = 0; i < n; i++){
+      V j = phi[i];
+      if(j >= 0){
+	const V m = ((i > j) ? i : j) + l;
+	if(m < n) l += lcp(x + i + l, x + j + l, n - m);
+      }
+      if(i > j)
+	sop(i, l, j, lps, prevOcc);
+      else
+	sop(j, l, i, lps, prevOcc);
+      l = (l > 0) ? l - 1 : 0;
+    }
+    lps[0] = 0;
+  }
+
+  template<class Index>
+  void lpfPrevOcc(const char * x, typename IndexValue<Index>::type n,
+		  const Index * phi, Index * lpspo){
+    typedef typename IndexValue<Index>::type V;
+    V i, l = 0;
+    for(i = 0; i < n; i++) LPS(i) = -1;
+    for(i = 0; i < n; i++){
+      V j = phi[i];
+      if(j >= 0){
+	const V m = ((i > j) ? i : j) + l;
+	if(m < n) l += lcp(x + i + l, x + j + l, n - m);
+      }
+      if(i > j)
+	sop(i, l, j, lpspo);
+      else
+	sop(j, l, i, lpspo);
+      l = (l > 0) ? l - 1 : 0;
+    }
+    LPS(0) = 0;
+  }
+
+  // lcp of x[i..n-1] and x[j..n-1], where i < j
+  template<class V>
+  inline V lcp(const char * const x, V i, V j, V n){
+    return lcp(x + i, x + j, n - j);
+  }
+
+  // li, lk = lcp of x[j..n-1] with x[i..n-1] and x[k..n-1] in one pass,
+  // where i, k < j. a negative position gives 0.
+  template<class V>
+  inline void lcp2(const char * const x, V i, V k, V j, V n, V & li, V & lk){
+    if(i < 0 || k < 0){
+      li = (i < 0) ? 0 : lcp(x, i, j, n);
+      lk = (k < 0) ? 0 : lcp(x, k, j, n);
+    } else {
+      size_t a, b;
+      lcp2(x + i, x + k, x + j, n - j, a, b);
+      li = a; lk = b;
+    }
+  }
+  
+  ////////////////////////////////////////////////////////////
+  // the factor starting at text position p:
+  // return its length and set prevPos, or return 0 for a literal.
+  // st = 2 for the interleaving versions.
+  ////////////////////////////////////////////////////////////
+
+  // PSV, NSV in text order
+  template<class Index, int st>
+  struct FactorTOPNSV {
+    typedef typename IndexValue<Index>::type V;
+    const char * s; V n; const Index * psv, * nsv;
+    FactorTOPNSV(const char * s, V n, const Index * psv, const Index * nsv)
+      : s(s), n(n), psv(psv), nsv(nsv){}
+    V operator()(V p, V & prevPos) const {
+      prevPos = psv[p*st];
+      const V nextPos = nsv[p*st];
+      V lpf, nlen;
+      lcp2(s, prevPos, nextPos, p, n, lpf, nlen);
+      if(nlen > lpf){ lpf = nlen; prevPos = nextPos; }
+      return lpf;
+    }
+  };
+
+  // PSV, NSV in lex order, values are lex ranks
+  template<class Index, int st>
+  struct FactorLOPNSV {
+    typedef typename IndexValue<Index>::type V;
+    const char * s; V n; const Index * sa, * rank, * psv, * nsv;
+    FactorLOPNSV(const char * s, V n, const Index * sa, const Index * rank,
+		 const Index * psv, const Index * nsv)
+      : s(s), n(n), sa(sa), rank(rank), psv(psv), nsv(nsv){}
+    V operator()(V p, V & prevPos) const {
+      V i = rank[p];
+      prevPos = (psv[i*st] < 0) ? -1 : V(sa[psv[i*st]]);
+      const V nextPos = (nsv[i*st] < 0) ? -1 : V(sa[nsv[i*st]]);
+      V lpf, nlen;
+      lcp2(s, prevPos, nextPos, p, n, lpf, nlen);
+      if(nlen > lpf){ lpf = nlen; prevPos = nextPos; }
+      return lpf;
+    }
+  };
+
+  // PSV, NSV in lex order, values are text positions
+  template<class Index, int st>
+  struct FactorLOPNSVtp {
+    typedef typename IndexValue<Index>::type V;
+    const char * s; V n; const Index * rank, * psv, * nsv;
+    FactorLOPNSVtp(const char * s, V n, const Index * rank,
+		   const Index * psv, const Index * nsv)
+      : s(s), n(n), rank(rank), psv(psv), nsv(nsv){}
+    V operator()(V p, V & prevPos) const {
+      V i = rank[p];
+      prevPos = psv[i*st];
+      const V nextPos = nsv[i*st];
+      V lpf, nlen;
+      lcp2(s, prevPos, nextPos, p, n, lpf, nlen);
+      if(nlen > lpf){ lpf = nlen; prevPos = nextPos; }
+      return lpf;
+    }
+  };
+
+  // LPF and PrevOcc in text order
+  template<class Index, int st>
+  struct FactorTOLPFPO {
+    typedef typename IndexValue<Index>::type V;
+    const Index * lps, * prevOcc;
+    FactorTOLPFPO(const Index * lps, const Index * prevOcc)
+      : lps(lps), prevOcc(prevOcc){}
+    V operator()(V p, V & prevPos) const {
+      if(lps[p*st] < 1) return 0;
+      prevPos = prevOcc[p*st];
+      return lps[p*st];
+    }
+  };
+
+  // factors of a block of the text, for the parallel parse
+  template<class V>
+  struct FactorBuffer {
+    std::vector<std::pair<V,V> > lz;
+    void factor(V len, V prev){ lz.push_back(std::make_pair(len, prev)); }
+  };
+
+  // greedy parse of s[p..] until position end is reached or passed,
+  // passing the factors to out (Sink or FactorBuffer).
+  // return the position following the last factor.
+  template<class V, class Factor, class Out>
+  static V lzParse(const char * s, V p, V end, const Factor & factor, Out & out){
+    V prevPos = 0;
+    while(p < end){
+      V lpf = factor(p, prevPos);
       if(lpf > 0){
-	lz.push_back(std::make_pair(lpf,prevPos));
+	out.factor(lpf, prevPos);
 	p += lpf;
       } else {
-	lz.push_back(std::make_pair(0, s[p]));
+	out.factor(0, s[p]);
 	p++;
       }
     }
-    return;
-    ////////////////////////////////////////////////////////////
+    return p;
   }
 
-  void lzFromTOLPFPO(const std::string & s,
-		     const int * lps,
-		     const int * prevOcc,
-		     std::vector<std::pair<int,int> > & lz){
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      if( lps[p] < 1 ){
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
-      } else {
-	lz.push_back(std::make_pair(lps[p], prevOcc[p]));
-	p += lps[p];
+  ////////////////////////////////////////////////////////////
+  // main LZ factorization
+  // with several threads, the text is parsed in rounds: the next
+  // nb * LZ_BLOCK positions (at most) are split into one block per
+  // thread, and each block is parsed speculatively from its first position
+  // in parallel. the greedy parse from a given position is unique,
+  // so once the actual parse reaches a factor start of the
+  // speculative parse of a block, the rest of the block is taken from it.
+  // until then (usually only a few factors), the actual parse is
+  // computed sequentially. the factors of a round are buffered
+  // until they are passed to sink, and the next round starts where
+  // the actual parse ended.
+  ////////////////////////////////////////////////////////////
+  template<class V, class Factor>
+  static void lzFactorize(const char * s, V n, const Factor & factor, Sink & sink,
+			  V start = 0){
+    if(start >= n) return;
+    if(start == 0){
+      sink.factor(0, s[0]);
+      start = 1;
+    }
+#ifdef _OPENMP
+    const V minBlock = 1 << 16, threads = omp_get_max_threads();
+    if(threads >= 2 && n - start >= 2 * minBlock){
+      std::vector<FactorBuffer<V> > blz(threads);
+      V p = start;
+      while(true){
+	V nb = std::min(threads, (n - p) / minBlock);
+	if(nb < 2) break;
+	const V r = p, bs = std::min(V(LZ_BLOCK), (n - p) / nb);
+#pragma omp parallel for num_threads(nb) schedule(static, 1)
+	for(V b = 0; b < nb; b++){
+	  blz[b].lz.clear();
+	  lzParse(s, V(r + b * bs), V(r + (b + 1) * bs), factor, blz[b]);
+	}
+	for(V b = 0; b < nb; b++){
+	  const std::vector<std::pair<V,V> > & bl = blz[b].lz;
+	  V q = r + b * bs;
+	  size_t k = 0;
+	  while(p < r + (b + 1) * bs){
+	    for(; k < bl.size() && q < p; k++) q += (bl[k].first > 0) ? bl[k].first : 1;
+	    if(q == p){ // synchronized
+	      for(; k < bl.size(); k++){
+		sink.factor(bl[k].first, bl[k].second);
+		p += (bl[k].first > 0) ? bl[k].first : 1;
+	      }
+	      break;
+	    }
+	    V next = p + 1;
+	    p = lzParse(s, p, next, factor, sink);
+	  }
+	}
       }
+      start = p;
     }
+#endif
+    lzParse(s, start, n, factor, sink);
   }
 
-  void lzFromTOLPFPO(const std::string & s,
-		     const int * lpspo,
-		     std::vector<std::pair<int,int> > & lz){
-    size_t p = 1;
-    lz.clear();
-    lz.push_back(std::make_pair(0, s[0]));
-    while(p < s.size()){
-      if( LPS(p) < 1 ){
-	lz.push_back(std::make_pair(0, s[p]));
-	p++;
-      } else {
-	lz.push_back(std::make_pair(LPS(p), PREVOCC(p)));
-	p += LPS(p);
+  template<class Index>
+  void lzFromTOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * psv,
+		    const Index * nsv,
+		    Sink & sink){
+    lzFactorize(s, n, FactorTOPNSV<Index,1>(s, n, psv, nsv), sink);
+  }
+
+  template<class Index>
+  void lzFromTOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * pnsv,
+		    Sink & sink){
+    lzFactorize(s, n, FactorTOPNSV<Index,2>(s, n, pnsv, pnsv + 1), sink);
+  }
+
+  template<class Index>
+  void lzFromTOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    typename IndexValue<Index>::type start,
+		    const Index * psv,
+		    const Index * nsv,
+		    Sink & sink){
+    lzFactorize(s, n, FactorTOPNSV<Index,1>(s, n, psv, nsv), sink, start);
+  }
+
+  template<class Index>
+  void lzFromLOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * sa,
+		    const Index * rank,
+		    const Index * psv,
+		    const Index * nsv,
+		    Sink & sink){
+    lzFactorize(s, n, FactorLOPNSV<Index,1>(s, n, sa, rank, psv, nsv), sink);
+  }
+
+  template<class Index>
+  void lzFromLOPNSVtp(const char * s, typename IndexValue<Index>::type n,
+		      const Index * sa,
+		      const Index * rank,
+		      const Index * psv,
+		      const Index * nsv,
+		      Sink & sink){
+    lzFactorize(s, n, FactorLOPNSVtp<Index,1>(s, n, rank, psv, nsv), sink);
+  }
+
+  template<class Index>
+  void lzFromLOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * sa,
+		    const Index * rank,
+		    const Index * pnsv,
+		    Sink & sink){
+    lzFactorize(s, n, FactorLOPNSV<Index,2>(s, n, sa, rank, pnsv, pnsv + 1), sink);
+  }
+
+  template<class Index>
+  void lzFromLOPNSVtp(const char * s, typename IndexValue<Index>::type n,
+		      const Index * sa,
+		      const Index * rank,
+		      const Index * pnsv,
+		      Sink & sink){
+    lzFactorize(s, n, FactorLOPNSVtp<Index,2>(s, n, rank, pnsv, pnsv + 1), sink);
+  }
+
+  template<class Index>
+  void lzFromTOLPFPO(const char * s, typename IndexValue<Index>::type n,
+		     const Index * lps,
+		     const Index * prevOcc,
+		     Sink & sink){
+    lzFactorize(s, n, FactorTOLPFPO<Index,1>(lps, prevOcc), sink);
+  }
+
+  template<class Index>
+  void lzFromTOLPFPO(const char * s, typename IndexValue<Index>::type n,
+		     const Index * lpspo,
+		     Sink & sink){
+    lzFactorize(s, n, FactorTOLPFPO<Index,2>(lpspo, lpspo + 1), sink);
+  }
+
+  ////////////////////////////////////////////////////////////
+  // decoding. factors are copied with memcpy: a factor that
+  // overlaps its source (p - prev < len) repeats t[prev..p-1],
+  // so it is copied in pieces of p - prev, 2(p - prev), ... bytes
+  // that do not overlap.
+  ////////////////////////////////////////////////////////////
+  static inline void copyFactor(char * t, int64_t n, int64_t p, int64_t prev, int64_t len){
+    int64_t d = p - prev;
+    if(d >= 16 && len <= 16 && p + 16 <= n){
+      memcpy(t + p, t + prev, 16); // fixed size copy for short factors
+    } else if(d >= len){
+      memcpy(t + p, t + prev, len);
+    } else if(d == 1){
+      memset(t + p, t[prev], len);
+    } else {
+      while(len > 0){
+	const int64_t c = len < d ? len : d;
+	memcpy(t + p, t + prev, c);
+	p += c; len -= c; d += c;
       }
     }
   }
 
-  std::string lz2str(const std::vector<std::pair<int,int> > & lz){
-    std::string s;
-    size_t i;
-    int j;
-    for(i = 0; i < lz.size(); i++){
-      if(lz[i].first == 0){
-	s.push_back(static_cast<char>(lz[i].second));
-      } else {
-	for(j = 0; j < lz[i].first; j++){
-	  s.push_back(s[lz[i].second+j]);
-	}
-      }
+  void DecodeSink::factor(int64_t len, int64_t prev){
+    if(next) next->factor(len, prev);
+    if(!ok) return;
+    if(len == 0){
+      if(pos >= n){ ok = false; return; }
+      t[pos++] = static_cast<char>(prev);
+    } else {
+      if(len < 0 || len > n - pos || prev < 0 || prev >= pos){ ok = false; return; }
+      copyFactor(t, n, pos, prev, len);
+      pos += len;
     }
+  }
+
+  template<class Value>
+  int64_t lzLength(const std::vector<std::pair<Value,Value> > & lz){
+    int64_t n = 0;
+    for(size_t i = 0; i < lz.size(); i++)
+      n += lz[i].first == 0 ? 1 : int64_t(lz[i].first);
+    return n;
+  }
+
+  template<class Value>
+  int64_t lzDecode(const std::vector<std::pair<Value,Value> > & lz, char * t){
+    DecodeSink d(t, lzLength(lz));
+    for(size_t i = 0; i < lz.size() && d.good(); i++)
+      d.DecodeSink::factor(lz[i].first, lz[i].second);
+    return d.size();
+  }
+
+  template<class Value>
+  std::string lz2str(const std::vector<std::pair<Value,Value> > & lz){
+    std::string s(lzLength(lz), '\0');
+    if(!s.empty()) s.resize(lzDecode(lz, &s[0]));
     return(s);
   }
 
+  ////////////////////////////////////////////////////////////
+  // explicit instantiations for each index type
+  ////////////////////////////////////////////////////////////
+#define LZBG_INSTANTIATE(Index)						\
+  template void pnsvStack(const Index *, IndexValue<Index>::type, Index *, Index *); \
+  template void pnsvStack(const Index *, IndexValue<Index>::type, Index *); \
+  template void pnsvLex(const Index *, IndexValue<Index>::type, Index *, Index *); \
+  template void pnsvLex(const Index *, IndexValue<Index>::type, Index *); \
+  template void pnsvText(const Index *, IndexValue<Index>::type, Index *, Index *); \
+  template void pnsvText(const Index *, IndexValue<Index>::type, Index *); \
+  template void pnsvTextFromSA(Index *, IndexValue<Index>::type, Index *); \
+  template void lpfPrevOcc(const char *, IndexValue<Index>::type, const Index *, Index *, Index *); \
+  template void lpfPrevOcc(const char *, IndexValue<Index>::type, const Index *, Index *); \
+  template void lzFromTOPNSV(const char *, IndexValue<Index>::type, const Index *, const Index *, \
+			     Sink &);					\
+  template void lzFromTOPNSV(const char *, IndexValue<Index>::type, const Index *, Sink &); \
+  template void lzFromTOPNSV(const char *, IndexValue<Index>::type, IndexValue<Index>::type, \
+			     const Index *, const Index *, Sink &);	\
+  template void lzFromLOPNSV(const char *, IndexValue<Index>::type, const Index *, const Index *, \
+			     const Index *, const Index *, Sink &);	\
+  template void lzFromLOPNSV(const char *, IndexValue<Index>::type, const Index *, const Index *, \
+			     const Index *, Sink &);			\
+  template void lzFromLOPNSVtp(const char *, IndexValue<Index>::type, const Index *, const Index *, \
+			       const Index *, const Index *, Sink &);	\
+  template void lzFromLOPNSVtp(const char *, IndexValue<Index>::type, const Index *, const Index *, \
+			       const Index *, Sink &);			\
+  template void lzFromTOLPFPO(const char *, IndexValue<Index>::type, const Index *, const Index *, \
+			      Sink &);					\
+  template void lzFromTOLPFPO(const char *, IndexValue<Index>::type, const Index *, Sink &);
+
+  LZBG_INSTANTIATE(int32_t)
+  LZBG_INSTANTIATE(uint40_t)
+  LZBG_INSTANTIATE(int64_t)
+
+  template std::string lz2str(const std::vector<std::pair<int32_t,int32_t> > &);
+  template std::string lz2str(const std::vector<std::pair<int64_t,int64_t> > &);
+  template int64_t lzLength(const std::vector<std::pair<int32_t,int32_t> > &);
+  template int64_t lzLength(const std::vector<std::pair<int64_t,int64_t> > &);
+  template int64_t lzDecode(const std::vector<std::pair<int32_t,int32_t> > &, char *);
+  template int64_t lzDecode(const std::vector<std::pair<int64_t,int64_t> > &, char *);
+
+  ////////////////////////////////////////////////////////////
+  // hash: four lanes of multiply-rotate rounds (as in xxhash64)
+  ////////////////////////////////////////////////////////////
+  static const uint64_t HP1 = 0x9e3779b185ebca87ULL, HP2 = 0xc2b2ae3d27d4eb4fULL;
+
+  static inline uint64_t hashRound(uint64_t h, uint64_t w){
+    h += w * HP2;
+    h = (h << 31) | (h >> 33);
+    return h * HP1;
+  }
+
+  uint64_t textHash(const char * s, size_t n){
+    uint64_t h[4] = { HP1 + HP2, HP2, 0, 0 - HP1 };
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      for(int k = 0; k < 4; k++){
+	uint64_t w;
+	memcpy(&w, s + i + 8 * k, 8);
+	h[k] = hashRound(h[k], w);
+      }
+    }
+    uint64_t x = n;
+    for(int k = 0; k < 4; k++) x = hashRound(x, h[k]);
+    for(; i < n; i++) x = hashRound(x, static_cast<uint8_t>(s[i]));
+    x ^= x >> 33; x *= HP2;
+    x ^= x >> 29; x *= HP1;
+    return x ^ (x >> 32);
+  }
+
   double gettime(){
     struct timeval tv;
     gettimeofday(&tv, NULL);
@@ -18,15 +18,121 @@
 #ifndef __LZBG_COMMON_HPP__
 #define __LZBG_COMMON_HPP__
 
+#include <stdint.h>
 #include <string>
 #include <vector>
+#include "bgIndex.hpp"
 
 namespace LZBG {
 
+  // index type of the suffix array and PSV/NSV arrays used by the programs,
+  // and the integer type for text positions.
+  // compile with -DLZBG_40BIT or -DLZBG_64BIT to process texts of 2GiB or more.
+#if defined(LZBG_64BIT)
+  typedef int64_t saidx_t;
+#elif defined(LZBG_40BIT)
+  typedef uint40_t saidx_t;
+#else
+  typedef int32_t saidx_t;
+#endif
+  typedef IndexValue<saidx_t>::type savalue_t;
+
   extern bool checkResult;
+  extern std::string outFile; // output file for the factorization (-o)
+  extern bool compressSA;      // write the suffix array cache compressed (-z)
+
+  // receives the factors in text order:
+  //   (length of factor, previous occurrence) if LPF > 0, or (0, T[p]).
+  class Sink {
+  public:
+    virtual ~Sink(){}
+    virtual void factor(int64_t len, int64_t prev) = 0;
+  };
+
+  // sink that appends factors to a vector
+  class VectorSink : public Sink {
+  public:
+    VectorSink(std::vector<std::pair<int64_t,int64_t> > & lz) : lz(lz){}
+    void factor(int64_t len, int64_t prev){ lz.push_back(std::make_pair(len, prev)); }
+  private:
+    std::vector<std::pair<int64_t,int64_t> > & lz;
+  };
+
+  // sink that counts factors, and also appends them to *lz if lz != 0
+  // and passes them on to *next if next != 0
+  class CountSink : public Sink {
+  public:
+    CountSink(std::vector<std::pair<savalue_t,savalue_t> > * lz = 0, Sink * next = 0)
+      : count(0), lz(lz), next(next){}
+    void factor(int64_t len, int64_t prev){
+      count++;
+      if(lz) lz->push_back(std::make_pair(savalue_t(len), savalue_t(prev)));
+      if(next) next->factor(len, prev);
+    }
+    size_t count;
+  private:
+    std::vector<std::pair<savalue_t,savalue_t> > * lz;
+    Sink * next;
+  };
   
+  // sink that decodes the factors into t[0..n-1], allocated by the caller
+  // (n is known from the factor file, or computed with lzLength).
+  // factors that do not fit in t or refer to undecoded positions are
+  // dropped, and good() returns false.
+  // all factors are also passed on to next (if not 0).
+  class DecodeSink : public Sink {
+  public:
+    DecodeSink(char * t, int64_t n, Sink * next = 0)
+      : t(t), n(n), pos(0), ok(true), next(next){}
+    void factor(int64_t len, int64_t prev);
+    // number of characters decoded
+    int64_t size() const { return pos; }
+    bool good() const { return ok; }
+  private:
+    char * t;
+    int64_t n, pos;
+    bool ok;
+    Sink * next;
+  };
+
+  // read-only view of the input text T[0..n-1]: a file mapped into memory,
+  // or a string read from the file (if mapping is not possible).
+  // the text is not 0 terminated.
+  class Text {
+  public:
+    enum MAP_FLAGS {
+      POPULATE = 1,  // fault in all pages while mapping (MAP_POPULATE)
+      SEQUENTIAL = 2 // read ahead aggressively (MADV_SEQUENTIAL)
+    };
+    Text() : p(""), n(0), map(0), hashed(false){}
+    ~Text(){ release(); }
+    const char * data() const { return p; }
+    size_t size() const { return n; }
+    bool operator==(const std::string & t) const;
+    bool operator!=(const std::string & t) const { return !(*this == t); }
+    // map file fileName read-only. return false if it cannot be mapped.
+    bool mapFile(const std::string & fileName, unsigned int flags = 0);
+    // read file fileName into memory
+    void readFile(const std::string & fileName);
+    // textHash of the text (computed once)
+    uint64_t hash() const;
+  private:
+    Text(const Text &);
+    Text & operator=(const Text &);
+    void release();
+    const char * p;
+    size_t n;
+    void * map;
+    std::string str;
+    mutable uint64_t hashValue;
+    mutable bool hashed;
+  };
+
   enum FLAGS {
-    DOUBLE_SA = 1 // allocate double required memory for suffix array
+    DOUBLE_SA = 1,  // allocate double required memory for suffix array
+    READONLY_SA = 2, // suffix array is not modified: the cache may be mapped
+    LAZY_SA = 4      // Init only allocates the suffix array (returns 0 if also
+                     // READONLY_SA, so that loadSA may map the cache): see loadSA
   };
   
   // print usage information
@@ -34,85 +140,225 @@ namespace LZBG {
 
   // parse options and read/construct string & suffix array
   // allocates memory if sa == 0. return memory for sa.
-  int * Init(int argc, char * argv[], std::string & s, 
-	     unsigned int f = 0, int *sa = 0);
+  saidx_t * Init(int argc, char * argv[], Text & s, 
+	     unsigned int f = 0, saidx_t *sa = 0);
+
+  // construct the suffix array of s into sa (or read it from the cache with -x)
+  // for a program that called Init with f & LAZY_SA. return sa.
+  saidx_t * loadSA(const Text & s, saidx_t * sa, unsigned int f = 0);
+
+  // with -p, read the arrays a[0..k-1] of s.size() indices each, computed
+  // by program name, from iFile + '.' + name + '.pnsv' ('.pnsv40', '.pnsv64'),
+  // if it is valid for s (see bgCache.hpp). return false if the arrays are
+  // to be computed, and saved by saveArrays.
+  bool loadArrays(const Text & s, const char * name, saidx_t * const * a, int k);
+  void saveArrays(const Text & s, const char * name, const saidx_t * const * a, int k);
+
+  // set the number of threads used by the parallel phases (OpenMP)
+  void setThreads(int threads);
 
   // read file fileName into string s.
   void stringFromFile(const std::string & fileName, std::string & s);
 
   // calculate suffix array sa from s. allocates memory if sa == 0
   // return *sa
-  int * suffixArray(const std::string & s, int * sa, unsigned int f);
+  saidx_t * suffixArray(const Text & s, saidx_t * sa, unsigned int f);
+
+  // calculate suffix array of T[0..n-1] into sa[0..n-1],
+  // where sasize is the number of elements allocated for sa.
+  // 40 bit indices are computed by divsufsort64 and packed afterwards,
+  // in place if sa has room for n 64 bit values, or using a temporary buffer.
+  // bucket is working memory of DIVSUFSORT_BUCKET_SIZE 32 bit (int32_t sa)
+  // or 64 bit values that is reused across calls, or 0 to allocate it.
+  // return 0 if no error occurred.
+  int divsufsort(const unsigned char * T, int32_t * sa, int32_t n, size_t sasize,
+		 void * bucket = 0);
+  int divsufsort(const unsigned char * T, uint40_t * sa, int64_t n, size_t sasize,
+		 void * bucket = 0);
+  int divsufsort(const unsigned char * T, int64_t * sa, int64_t n, size_t sasize,
+		 void * bucket = 0);
 
   // read suffix array of string s from fname + '.sa' into sa.
-  // if safname does not exist or seems invalid, create suffix array and save it
-  // to fname + '.sa'
-  // allocates memory if *sa == 0
+  // if safname does not exist or is not valid for s (see bgCache.hpp), create suffix array and save it
+  // to fname + '.sa' ('.sa40', '.sa64' for 40 and 64 bit indices)
+  // allocates memory if *sa == 0, or maps the file read-only
+  // if also f & READONLY_SA and the file is not compressed
+  // the file is saved on a background thread that is waited for at exit,
+  // from sa itself if f & READONLY_SA (sa must not be freed until then)
   // return *sa
-  int * saFromFile(const std::string & s, const std::string & fname, 
-		   int * sa, unsigned int f);
+  saidx_t * saFromFile(const Text & s, const std::string & fname, 
+		   saidx_t * sa, unsigned int f);
 
+  // open the (uncompressed) suffix array cache fname + '.sa' of s for
+  // reading the suffix array from offset sizeof(CacheHeader) (see bgCache.hpp).
+  // if it does not exist or is not valid for s, the suffix array is
+  // constructed in memory and saved first (replacing a compressed cache).
+  // return a file descriptor or -1.
+  int openSA(const Text & s, const std::string & fname);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // The following routines are templates on the index type (Index),
+  // instantiated for int32_t, uint40_t and int64_t.
+  // Values are computed with IndexValue<Index>::type.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // computing PSV, NSV in lex order using stack
+  // values are text positions
+  ////////////////////////////////////////////////////////////////////////////////
+  template<class Index>
+  void pnsvStack(const Index * sa, typename IndexValue<Index>::type n,
+		 Index * psv, Index * nsv);
+
+  // interleaving version
+  template<class Index>
+  void pnsvStack(const Index * sa, typename IndexValue<Index>::type n,
+		 Index * pnsv);
 
   ////////////////////////////////////////////////////////////////////////////////
-  // computing lz from PSV, NSV in text order
+  // computing PSV, NSV in lex order using peak elimination
+  // values are lex ranks
   ////////////////////////////////////////////////////////////////////////////////
-  void lzFromTOPNSV(const std::string & s, 
-		    const int * psv,
-		    const int * nsv,
-		    std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void pnsvLex(const Index * sa, typename IndexValue<Index>::type n,
+	       Index * psv, Index * nsv);
 
   // interleaving version
-  void lzFromTOPNSV(const std::string & s, 
-		    const int * pnsv,
-		    std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void pnsvLex(const Index * sa, typename IndexValue<Index>::type n,
+	       Index * pnsv);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // computing PSV, NSV in text order using peak elimination on phi,
+  // where phi[sa[0]] = sa[n-1] and phi[sa[i]] = sa[i-1]
+  ////////////////////////////////////////////////////////////////////////////////
+  template<class Index>
+  void pnsvText(const Index * phi, typename IndexValue<Index>::type n,
+		Index * psv, Index * nsv);
+
+  // interleaving version
+  template<class Index>
+  void pnsvText(const Index * phi, typename IndexValue<Index>::type n,
+		Index * pnsv);
+
+  // computing phi and PSV, NSV in text order with 9N bytes:
+  // phi is computed into psv, and sa is overwritten by nsv
+  template<class Index>
+  void pnsvTextFromSA(Index * sa, typename IndexValue<Index>::type n,
+		      Index * psv);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // computing LPF and PrevOcc in text order (Ohlebusch & Gog),
+  // where phi[sa[0]] = -1 and phi[sa[i]] = sa[i-1]
+  ////////////////////////////////////////////////////////////////////////////////
+  template<class Index>
+  void lpfPrevOcc(const char * s, typename IndexValue<Index>::type n,
+		  const Index * phi, Index * lps, Index * prevOcc);
+
+  // interleaving version
+  template<class Index>
+  void lpfPrevOcc(const char * s, typename IndexValue<Index>::type n,
+		  const Index * phi, Index * lpspo);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // computing lz from PSV, NSV in text order.
+  // the factors are passed to sink in text order as they are computed
+  // (with several threads, after each round of LZ_BLOCK positions per
+  // thread, so that at most that many factors per thread are buffered).
+  ////////////////////////////////////////////////////////////////////////////////
+  static const int64_t LZ_BLOCK = 1 << 18;
+
+  template<class Index>
+  void lzFromTOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * psv,
+		    const Index * nsv,
+		    Sink & sink);
+
+  // interleaving version
+  template<class Index>
+  void lzFromTOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * pnsv,
+		    Sink & sink);
+
+  // factors of s[start..n-1] only, which refer to any previous position
+  // of s (for a window of the text, where s[0..start-1] precedes the block).
+  // psv, nsv are those of s[0..n-1], and the positions passed to sink
+  // are relative to s.
+  template<class Index>
+  void lzFromTOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    typename IndexValue<Index>::type start,
+		    const Index * psv,
+		    const Index * nsv,
+		    Sink & sink);
 
   ////////////////////////////////////////////////////////////////////////////////
   // computing lz from PSV, NSV in lex order
   ////////////////////////////////////////////////////////////////////////////////
-  void lzFromLOPNSV(const std::string & s,
-		    const int * sa,
-		    const int * rank,
-		    const int * psv,
-		    const int * nsv,
-		    std::vector<std::pair<int,int> > & lz);
-
-  // values of psv and nsv as text positions
-  void lzFromLOPNSVtp(const std::string & s,
-		      const int * sa,
-		      const int * rank,
-		      const int * psv,
-		      const int * nsv,
-		      std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void lzFromLOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * sa,
+		    const Index * rank,
+		    const Index * psv,
+		    const Index * nsv,
+		    Sink & sink);
+
+  // values of psv and nsv as text positions (sa is not used, and may be 0)
+  template<class Index>
+  void lzFromLOPNSVtp(const char * s, typename IndexValue<Index>::type n,
+		      const Index * sa,
+		      const Index * rank,
+		      const Index * psv,
+		      const Index * nsv,
+		      Sink & sink);
 
   // interleaving version of lzFromLOPNSV
-  void lzFromLOPNSV(const std::string & s,
-		    const int * sa,
-		    const int * rank,
-		    const int * pnsv,
-		    std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void lzFromLOPNSV(const char * s, typename IndexValue<Index>::type n,
+		    const Index * sa,
+		    const Index * rank,
+		    const Index * pnsv,
+		    Sink & sink);
 
   // interleaving version of lzFromLOPNSVtp
-  void lzFromLOPNSVtp(const std::string & s,
-		      const int * sa,
-		      const int * rank,
-		      const int * pnsv,
-		      std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void lzFromLOPNSVtp(const char * s, typename IndexValue<Index>::type n,
+		      const Index * sa,
+		      const Index * rank,
+		      const Index * pnsv,
+		      Sink & sink);
 
   ////////////////////////////////////////////////////////////////////////////////
   // computing lz from LPF and PrevOcc in text order
   ////////////////////////////////////////////////////////////////////////////////
-  void lzFromTOLPFPO(const std::string & s,
-		     const int * lps,
-		     const int * prevOcc,
-		      std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void lzFromTOLPFPO(const char * s, typename IndexValue<Index>::type n,
+		     const Index * lps,
+		     const Index * prevOcc,
+		     Sink & sink);
 
   // interleaving version
-  void lzFromTOLPFPO(const std::string & s,
-		     const int * lpspo,
-		     std::vector<std::pair<int,int> > & lz);
+  template<class Index>
+  void lzFromTOLPFPO(const char * s, typename IndexValue<Index>::type n,
+		     const Index * lpspo,
+		     Sink & sink);
 
   // recover string from lz factorization
-  std::string lz2str(const std::vector<std::pair<int,int> > & lz);
+  // (instantiated for int32_t and int64_t)
+  template<class Value>
+  std::string lz2str(const std::vector<std::pair<Value,Value> > & lz);
+
+  // length of the string of lz factorization
+  template<class Value>
+  int64_t lzLength(const std::vector<std::pair<Value,Value> > & lz);
+
+  // decode lz factorization into t[0..lzLength(lz)-1].
+  // return the number of characters decoded (less if lz is invalid)
+  template<class Value>
+  int64_t lzDecode(const std::vector<std::pair<Value,Value> > & lz, char * t);
   double gettime();
+
+  // 64 bit hash of s[0..n-1], computed 32 bytes at a time
+  // (to validate caches, not for adversarial input)
+  uint64_t textHash(const char * s, size_t n);
 };
 #endif//__LZBG_COMMON_HPP__
@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgExternal.cpp
+//   semi-external lz factorization
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "bgExternal.hpp"
+#include "bgCache.hpp"
+#include "bgLCP.hpp"
+
+namespace LZBG {
+
+  static const size_t IOBUF = 1 << 18;    // buffer of a sequential reader
+  static const size_t MINBUF = 1 << 12;   // least buffer of a range
+
+  // (SA[i], SA[PSV[i]], SA[NSV[i]])
+  struct Triple {
+    saidx_t p, psv, nsv;
+  };
+
+  // stack entry: SA[i], SA[PSV[i]]
+  struct StackEntry {
+    saidx_t v, psv;
+  };
+
+  static bool readFully(int fd, void * data, size_t size, off_t off){
+    char * p = static_cast<char *>(data);
+    while(size > 0){
+      const ssize_t r = pread(fd, p, size, off);
+      if(r <= 0) return false;
+      p += r; off += r; size -= r;
+    }
+    return true;
+  }
+
+  static bool writeFully(int fd, const void * data, size_t size, off_t off){
+    const char * p = static_cast<const char *>(data);
+    while(size > 0){
+      const ssize_t r = pwrite(fd, p, size, off);
+      if(r <= 0) return false;
+      p += r; off += r; size -= r;
+    }
+    return true;
+  }
+
+  ////////////////////////////////////////////////////////////
+  // n values of type T read from fd, starting at offset off
+  ////////////////////////////////////////////////////////////
+  template<class T>
+  class SeqReader {
+  public:
+    SeqReader(int fd, off_t off, uint64_t n, uint64_t & bytes)
+      : fd(fd), off(off), left(n), buf(std::max<size_t>(1, IOBUF / sizeof(T))),
+	pos(0), len(0), bytes(bytes), ok(true){}
+    bool next(T & x){
+      if(pos == len){
+	if(left == 0) return false;
+	len = std::min<uint64_t>(buf.size(), left);
+	if(!readFully(fd, &buf[0], len * sizeof(T), off)){
+	  ok = false;
+	  return false;
+	}
+	off += len * sizeof(T);
+	left -= len;
+	bytes += len * sizeof(T);
+	pos = 0;
+      }
+      x = buf[pos++];
+      return true;
+    }
+    bool good() const { return ok; }
+  private:
+    int fd;
+    off_t off;
+    uint64_t left;
+    std::vector<T> buf;
+    size_t pos, len;
+    uint64_t & bytes;
+    bool ok;
+  };
+
+  ////////////////////////////////////////////////////////////
+  // stack holding at most cap entries in memory: when full, the
+  // lower half is appended to a file, and read back when empty
+  ////////////////////////////////////////////////////////////
+  class ExternalStack {
+  public:
+    ExternalStack(const std::string & fileName, size_t cap, PhaseStats & stats)
+      : fileName(fileName), cap(std::max<size_t>(2, cap & ~size_t(1))), fd(-1),
+	spilled(0), stats(stats), ok(true){
+      buf.reserve(this->cap);
+    }
+    ~ExternalStack(){
+      if(fd >= 0){
+	close(fd);
+	unlink(fileName.c_str());
+      }
+    }
+    bool empty() const { return buf.empty() && spilled == 0; }
+    const StackEntry & top(){
+      if(buf.empty()) load();
+      return buf.back();
+    }
+    void pop(){
+      if(buf.empty()) load();
+      buf.pop_back();
+    }
+    void push(const StackEntry & e){
+      if(buf.size() == cap) spill();
+      buf.push_back(e);
+    }
+    bool good() const { return ok; }
+  private:
+    void spill(){
+      const size_t half = cap / 2, bytes = half * sizeof(StackEntry);
+      if(fd < 0) fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+      if(fd < 0 || !writeFully(fd, &buf[0], bytes, spilled * sizeof(StackEntry))) ok = false;
+      buf.erase(buf.begin(), buf.begin() + half);
+      spilled += half;
+      stats.written += bytes;
+    }
+    void load(){
+      const size_t half = cap / 2, bytes = half * sizeof(StackEntry);
+      spilled -= half;
+      buf.resize(half);
+      if(!readFully(fd, &buf[0], bytes, spilled * sizeof(StackEntry))) ok = false;
+      stats.read += bytes;
+    }
+    std::string fileName;
+    size_t cap;
+    int fd;
+    uint64_t spilled;  // entries in the file
+    std::vector<StackEntry> buf;
+    PhaseStats & stats;
+    bool ok;
+  };
+
+  ////////////////////////////////////////////////////////////
+  // files of the triples of each range of text positions.
+  // the buffer of a range is appended to its file when full.
+  ////////////////////////////////////////////////////////////
+  class RangeFiles {
+  public:
+    RangeFiles(const std::string & prefix, uint64_t range, size_t k, size_t bufSize,
+	       PhaseStats & stats)
+      : prefix(prefix), range(range), bufSize(bufSize), bufs(k), stats(stats), ok(true){
+      for(size_t b = 0; b < k; b++) bufs[b].reserve(bufSize);
+    }
+    ~RangeFiles(){
+      for(size_t b = 0; b < bufs.size(); b++) unlink(fileName(b).c_str());
+    }
+    std::string fileName(size_t b) const {
+      std::ostringstream os;
+      os << prefix << "." << b;
+      return os.str();
+    }
+    void put(const Triple & t){
+      std::vector<Triple> & buf = bufs[savalue_t(t.p) / range];
+      buf.push_back(t);
+      if(buf.size() >= bufSize) flush(savalue_t(t.p) / range);
+    }
+    void flush(size_t b){
+      std::vector<Triple> & buf = bufs[b];
+      if(buf.empty()) return;
+      const int fd = open(fileName(b).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+      const size_t bytes = buf.size() * sizeof(Triple);
+      if(fd < 0 || write(fd, &buf[0], bytes) != ssize_t(bytes)) ok = false;
+      if(fd >= 0) close(fd);
+      stats.written += bytes;
+      buf.clear();
+    }
+    void flush(){
+      for(size_t b = 0; b < bufs.size(); b++){
+	flush(b);
+	std::vector<Triple>().swap(bufs[b]);
+      }
+    }
+    bool good() const { return ok; }
+  private:
+    std::string prefix;
+    uint64_t range;
+    size_t bufSize;
+    std::vector<std::vector<Triple> > bufs;
+    PhaseStats & stats;
+    bool ok;
+  };
+
+  static void startPhase(PhaseStats & stats, struct rusage & ru){
+    stats.time = gettime();
+    stats.read = stats.written = 0;
+    getrusage(RUSAGE_SELF, &ru);
+  }
+
+  static void endPhase(PhaseStats & stats, const struct rusage & ru0){
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    stats.time = gettime() - stats.time;
+    stats.inBlocks = ru.ru_inblock - ru0.ru_inblock;
+    stats.outBlocks = ru.ru_oublock - ru0.ru_oublock;
+  }
+
+  ////////////////////////////////////////////////////////////
+  // memory besides the reader buffer (IOBUF): the PSV, NSV of a range
+  // in the lz phase, and in the pnsv phase half for the stack and half
+  // for the buffers of the k ranges, of MINBUF bytes at least.
+  // return false if memory is too small.
+  ////////////////////////////////////////////////////////////
+  static bool layout(uint64_t n, size_t memory, uint64_t & range, size_t & k,
+		     size_t & bufSize){
+    if(memory <= IOBUF) return false;
+    const size_t m = memory - IOBUF;
+    range = m / (2 * sizeof(saidx_t));
+    if(range == 0) return false;
+    k = n ? (n - 1) / range + 1 : 0;
+    const size_t perRange = m / 2 / std::max<size_t>(k, 1);
+    if(perRange < MINBUF + sizeof(std::vector<Triple>)) return false;
+    bufSize = (perRange - sizeof(std::vector<Triple>)) / sizeof(Triple);
+    return true;
+  }
+
+  size_t externalMinMemory(uint64_t n){
+    uint64_t range;
+    size_t k, bufSize, lo = IOBUF, hi = IOBUF + MINBUF * 4;
+    while(!layout(n, hi, range, k, bufSize)) hi *= 2;
+    while(hi - lo > 1){
+      const size_t mid = lo + (hi - lo) / 2;
+      if(layout(n, mid, range, k, bufSize)) hi = mid;
+      else lo = mid;
+    }
+    return hi;
+  }
+
+  bool lzExternal(const Text & s, int fd, size_t memory, const std::string & tmpPrefix,
+		  Sink & sink, PhaseStats stats[2]){
+    const savalue_t n = s.size();
+    const char * t = s.data();
+    uint64_t range;
+    size_t k, bufSize;
+    if(!layout(n, memory, range, k, bufSize)){
+      std::cerr << "ERROR: " << memory << " bytes of memory are too few for the text: "
+		<< externalMinMemory(n) << " bytes are needed at least." << std::endl;
+      close(fd);
+      return false;
+    }
+    struct rusage ru;
+    bool ok = true;
+
+    ////////////////////////////////////////////////////////////
+    // PSV, NSV in lex order, distributed to the ranges
+    ////////////////////////////////////////////////////////////
+    RangeFiles files(tmpPrefix, range, k, bufSize, stats[0]);
+    startPhase(stats[0], ru);
+    {
+      ExternalStack st(tmpPrefix + ".stack", (memory - IOBUF) / 2 / sizeof(StackEntry), stats[0]);
+      SeqReader<saidx_t> sa(fd, sizeof(CacheHeader), n, stats[0].read);
+      saidx_t x;
+      while(sa.next(x)){
+	while(!st.empty() && savalue_t(st.top().v) > savalue_t(x)){
+	  const Triple e = { st.top().v, st.top().psv, x };
+	  files.put(e);
+	  st.pop();
+	}
+	const StackEntry e = { x, st.empty() ? saidx_t(-1) : st.top().v };
+	st.push(e);
+      }
+      while(!st.empty()){
+	const Triple e = { st.top().v, st.top().psv, saidx_t(-1) };
+	files.put(e);
+	st.pop();
+      }
+      files.flush();
+      ok = sa.good() && st.good() && files.good();
+    }
+    close(fd);
+    endPhase(stats[0], ru);
+
+    ////////////////////////////////////////////////////////////
+    // lz factorization, a range at a time
+    ////////////////////////////////////////////////////////////
+    startPhase(stats[1], ru);
+    std::vector<saidx_t> psv(std::min<uint64_t>(range, n)), nsv(psv.size());
+    savalue_t p = 0;
+    for(size_t b = 0; ok && b < k; b++){
+      const savalue_t r0 = b * range, r1 = std::min<savalue_t>(n, r0 + range);
+      const std::string fname = files.fileName(b);
+      if(p >= r1){ // the range is within a factor
+	unlink(fname.c_str());
+	continue;
+      }
+      const int rfd = open(fname.c_str(), O_RDONLY);
+      if(rfd < 0){
+	ok = false;
+	break;
+      }
+      SeqReader<Triple> triples(rfd, 0, r1 - r0, stats[1].read);
+      Triple e;
+      while(triples.next(e)){
+	psv[savalue_t(e.p) - r0] = e.psv;
+	nsv[savalue_t(e.p) - r0] = e.nsv;
+      }
+      ok = triples.good();
+      close(rfd);
+      unlink(fname.c_str());
+      while(ok && p < r1){
+	const savalue_t a = psv[p - r0], c = nsv[p - r0];
+	size_t la = 0, lc = 0;
+	if(a >= 0 && c >= 0) lcp2(t + a, t + c, t + p, n - p, la, lc);
+	else if(a >= 0) la = lcp(t + a, t + p, n - p);
+	else if(c >= 0) lc = lcp(t + c, t + p, n - p);
+	if(la == 0 && lc == 0){
+	  sink.factor(0, t[p]);
+	  p++;
+	} else if(la >= lc){
+	  sink.factor(la, a);
+	  p += la;
+	} else {
+	  sink.factor(lc, c);
+	  p += lc;
+	}
+      }
+    }
+    endPhase(stats[1], ru);
+    if(!ok) std::cerr << "failed to read or write the temporary files: " << tmpPrefix << ".*" << std::endl;
+    return ok;
+  }
+}
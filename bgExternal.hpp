@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgExternal.hpp
+//   semi-external lz factorization: the suffix array and the PSV, NSV
+//   arrays are kept on disk and accessed in sequential passes
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+//
+// 1. pnsv: the suffix array is read sequentially from its cache file,
+//    and PSV, NSV in lex order are computed with a stack (as in BGS),
+//    whose bottom is moved to a file when it does not fit in memory.
+//    each (SA[i], SA[PSV[i]], SA[NSV[i]]) is appended to the file of
+//    the range of text positions containing SA[i].
+// 2. lz: the files are read in text order. the PSV, NSV of a range
+//    are placed in memory, and the factors starting in the range are
+//    computed from them as in BGT (the text is mapped into memory).
+//
+// I/O volume: 4N (suffix array) + 2 * 12N (ranges) bytes with 32 bit
+// indices, plus the stack if it does not fit in memory.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_EXTERNAL_HPP__
+#define __LZBG_EXTERNAL_HPP__
+
+#include <stdint.h>
+#include <string>
+#include "bgCommon.hpp"
+
+namespace LZBG {
+
+  // cost of a phase of lzExternal
+  struct PhaseStats {
+    double time;
+    uint64_t read, written;        // bytes of the arrays read and written
+    uint64_t inBlocks, outBlocks;  // blocks of 512 bytes read and written by
+                                   // the process (getrusage: includes the text)
+  };
+
+  // least memory for lzExternal on a text of length n: about
+  // 256 KB + 128 * sqrt(w * n) bytes for w bytes per index, so that
+  // the buffer of each range of text positions has 4 KB at least.
+  size_t externalMinMemory(uint64_t n);
+
+  // lz factorization of s, with the suffix array read from fd (see openSA),
+  // using at most memory bytes besides the text (including the I/O buffers),
+  // and temporary files tmpPrefix + '.0', '.1', ..., '.stack'.
+  // stats[0]: pnsv phase, stats[1]: lz phase. closes fd.
+  // return false if memory < externalMinMemory(s.size()) or on an I/O error.
+  bool lzExternal(const Text & s, int fd, size_t memory, const std::string & tmpPrefix,
+		  Sink & sink, PhaseStats stats[2]);
+};
+#endif//__LZBG_EXTERNAL_HPP__
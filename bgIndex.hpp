@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgIndex.hpp
+//   index types for text positions, suffix array, PSV/NSV arrays
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_INDEX_HPP__
+#define __LZBG_INDEX_HPP__
+
+#include <stdint.h>
+#include <string.h>
+
+namespace LZBG {
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // packed 5 byte index, for texts of up to 2^40 - 1 bytes.
+  // values are in [0, 2^40 - 2], and 2^40 - 1 is read back as -1, which is
+  // the only negative value stored by the kernels (undefined PSV/NSV, etc.)
+  ////////////////////////////////////////////////////////////////////////////////
+  struct uint40_t {
+    uint40_t(){}
+    uint40_t(int64_t x){
+      const uint32_t lo = static_cast<uint32_t>(x);
+      memcpy(b, &lo, 4);
+      b[4] = static_cast<uint8_t>(x >> 32);
+    }
+    operator int64_t() const {
+      uint32_t lo;
+      memcpy(&lo, b, 4);
+      const int64_t x = (static_cast<int64_t>(b[4]) << 32) | lo;
+      return x - (((x + 1) >> 40) << 40); // 2^40 - 1 -> -1
+    }
+    uint8_t b[5];
+  };
+
+  // integer type for arithmetic on values of an index type
+  template<class Index> struct IndexValue { typedef Index type; };
+  template<> struct IndexValue<uint40_t> { typedef int64_t type; };
+
+  // largest text length that can be processed with an index type
+  template<class Index> struct IndexLimit {};
+  template<> struct IndexLimit<int32_t> { static const int64_t max = INT32_MAX; };
+  template<> struct IndexLimit<uint40_t> { static const int64_t max = (int64_t(1) << 40) - 1; };
+  template<> struct IndexLimit<int64_t> { static const int64_t max = INT64_MAX; };
+};
+#endif//__LZBG_INDEX_HPP__
@@ -0,0 +1,296 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgLCP.cpp
+//   longest common prefix kernels and runtime cpu dispatch
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bgLCP.hpp"
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LZBG_LCP_WORD
+#if defined(__x86_64__) || defined(__i386__)
+#define LZBG_LCP_X86
+#include <immintrin.h>
+#endif
+#endif
+
+namespace LZBG {
+
+  ////////////////////////////////////////////////////////////
+  // one byte at a time
+  ////////////////////////////////////////////////////////////
+  static size_t lcpByte(const char * a, const char * b, size_t max){
+    size_t l = 0;
+    while(l < max && a[l] == b[l]) l++;
+    return l;
+  }
+
+  ////////////////////////////////////////////////////////////
+  // lcps of a and b with c in one pass over c:
+  // compare both while they match c, then only the survivor.
+  // the kernels below follow the same scheme.
+  ////////////////////////////////////////////////////////////
+  static void lcp2Byte(const char * a, const char * b, const char * c, size_t max,
+		       size_t & la, size_t & lb){
+    size_t l = 0;
+    while(l < max && a[l] == c[l] && b[l] == c[l]) l++;
+    la = (l < max && a[l] != c[l]) ? l : l + lcpByte(a + l, c + l, max - l);
+    lb = (l < max && b[l] != c[l]) ? l : l + lcpByte(b + l, c + l, max - l);
+  }
+
+#ifdef LZBG_LCP_WORD
+  ////////////////////////////////////////////////////////////
+  // 8 bytes at a time: the first differing byte is given by
+  // the trailing zeros of the xor (little endian)
+  ////////////////////////////////////////////////////////////
+  static size_t lcpWord(const char * a, const char * b, size_t max){
+    size_t l = 0;
+    for(; l + 8 <= max; l += 8){
+      uint64_t x, y;
+      memcpy(&x, a + l, 8);
+      memcpy(&y, b + l, 8);
+      if(x != y) return l + (__builtin_ctzll(x ^ y) >> 3);
+    }
+    return l + lcpByte(a + l, b + l, max - l);
+  }
+
+  static void lcp2Word(const char * a, const char * b, const char * c, size_t max,
+		       size_t & la, size_t & lb){
+    size_t l = 0;
+    for(; l + 8 <= max; l += 8){
+      uint64_t x, y, z;
+      memcpy(&x, c + l, 8);
+      memcpy(&y, a + l, 8);
+      memcpy(&z, b + l, 8);
+      const uint64_t da = x ^ y, db = x ^ z;
+      if(da | db){
+	la = da ? l + (__builtin_ctzll(da) >> 3) : l + 8 + lcpWord(a + l + 8, c + l + 8, max - l - 8);
+	lb = db ? l + (__builtin_ctzll(db) >> 3) : l + 8 + lcpWord(b + l + 8, c + l + 8, max - l - 8);
+	return;
+      }
+    }
+    lcp2Byte(a + l, b + l, c + l, max - l, la, lb);
+    la += l; lb += l;
+  }
+#endif
+
+#ifdef LZBG_LCP_X86
+  ////////////////////////////////////////////////////////////
+  // 16, 32, 64 bytes at a time: compare and take the mask of
+  // unequal bytes. the remainder is compared by words
+  // (not by the narrower kernels, to avoid mixing sse and avx code).
+  ////////////////////////////////////////////////////////////
+  __attribute__((target("sse2")))
+  static size_t lcpSSE(const char * a, const char * b, size_t max){
+    size_t l = 0;
+    for(; l + 16 <= max; l += 16){
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + l));
+      const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + l));
+      const unsigned m = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+      if(m) return l + __builtin_ctz(m);
+    }
+    return l + lcpWord(a + l, b + l, max - l);
+  }
+
+  __attribute__((target("sse2")))
+  static void lcp2SSE(const char * a, const char * b, const char * c, size_t max,
+		      size_t & la, size_t & lb){
+    size_t l = 0;
+    for(; l + 16 <= max; l += 16){
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c + l));
+      const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + l));
+      const __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + l));
+      const unsigned ma = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+      const unsigned mb = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, z)) & 0xffff;
+      if(ma | mb){
+	la = ma ? l + __builtin_ctz(ma) : l + 16 + lcpSSE(a + l + 16, c + l + 16, max - l - 16);
+	lb = mb ? l + __builtin_ctz(mb) : l + 16 + lcpSSE(b + l + 16, c + l + 16, max - l - 16);
+	return;
+      }
+    }
+    lcp2Word(a + l, b + l, c + l, max - l, la, lb);
+    la += l; lb += l;
+  }
+
+  __attribute__((target("avx2")))
+  static size_t lcpAVX2(const char * a, const char * b, size_t max){
+    size_t l = 0;
+    for(; l + 32 <= max; l += 32){
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + l));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + l));
+      const unsigned m = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+      if(m) return l + __builtin_ctz(m);
+    }
+    return l + lcpWord(a + l, b + l, max - l);
+  }
+
+  __attribute__((target("avx2")))
+  static void lcp2AVX2(const char * a, const char * b, const char * c, size_t max,
+		       size_t & la, size_t & lb){
+    size_t l = 0;
+    for(; l + 32 <= max; l += 32){
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + l));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + l));
+      const __m256i z = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + l));
+      const unsigned ma = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+      const unsigned mb = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, z)));
+      if(ma | mb){
+	la = ma ? l + __builtin_ctz(ma) : l + 32 + lcpAVX2(a + l + 32, c + l + 32, max - l - 32);
+	lb = mb ? l + __builtin_ctz(mb) : l + 32 + lcpAVX2(b + l + 32, c + l + 32, max - l - 32);
+	return;
+      }
+    }
+    lcp2Word(a + l, b + l, c + l, max - l, la, lb);
+    la += l; lb += l;
+  }
+
+  __attribute__((target("avx512f,avx512bw,avx512vl")))
+  static size_t lcpAVX512(const char * a, const char * b, size_t max){
+    size_t l = 0;
+    for(; l + 64 <= max; l += 64){
+      const __m512i x = _mm512_loadu_si512(a + l);
+      const __m512i y = _mm512_loadu_si512(b + l);
+      const uint64_t m = _mm512_cmpneq_epi8_mask(x, y);
+      if(m) return l + __builtin_ctzll(m);
+    }
+    if(l + 32 <= max){
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + l));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + l));
+      const unsigned m = _mm256_cmpneq_epi8_mask(x, y);
+      if(m) return l + __builtin_ctz(m);
+      l += 32;
+    }
+    return l + lcpWord(a + l, b + l, max - l);
+  }
+
+  __attribute__((target("avx512f,avx512bw,avx512vl")))
+  static void lcp2AVX512(const char * a, const char * b, const char * c, size_t max,
+			 size_t & la, size_t & lb){
+    size_t l = 0;
+    for(; l + 64 <= max; l += 64){
+      const __m512i x = _mm512_loadu_si512(c + l);
+      const __m512i y = _mm512_loadu_si512(a + l);
+      const __m512i z = _mm512_loadu_si512(b + l);
+      const uint64_t ma = _mm512_cmpneq_epi8_mask(x, y);
+      const uint64_t mb = _mm512_cmpneq_epi8_mask(x, z);
+      if(ma | mb){
+	la = ma ? l + __builtin_ctzll(ma) : l + 64 + lcpAVX512(a + l + 64, c + l + 64, max - l - 64);
+	lb = mb ? l + __builtin_ctzll(mb) : l + 64 + lcpAVX512(b + l + 64, c + l + 64, max - l - 64);
+	return;
+      }
+    }
+    lcp2Word(a + l, b + l, c + l, max - l, la, lb);
+    la += l; lb += l;
+  }
+#endif
+
+  ////////////////////////////////////////////////////////////
+  // runtime dispatch
+  ////////////////////////////////////////////////////////////
+  struct LCPEntry {
+    const char * name;
+    LCPKernel kernel;
+    LCP2Kernel kernel2;
+  };
+
+  // in order of preference (last supported is used)
+  static const LCPEntry lcpKernels[] = {
+    { "byte", lcpByte, lcp2Byte },
+#ifdef LZBG_LCP_WORD
+    { "word", lcpWord, lcp2Word },
+#endif
+#ifdef LZBG_LCP_X86
+    { "sse", lcpSSE, lcp2SSE },
+    { "avx2", lcpAVX2, lcp2AVX2 },
+    { "avx512", lcpAVX512, lcp2AVX512 },
+#endif
+  };
+  static const size_t numLCPKernels = sizeof(lcpKernels) / sizeof(lcpKernels[0]);
+
+  static bool supported(const LCPEntry & e){
+#ifdef LZBG_LCP_X86
+    __builtin_cpu_init();
+    if(e.kernel == lcpSSE) return __builtin_cpu_supports("sse2");
+    if(e.kernel == lcpAVX2) return __builtin_cpu_supports("avx2");
+    if(e.kernel == lcpAVX512)
+      return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+#endif
+    return true;
+  }
+
+  static const LCPEntry * selectLCPKernel(){
+    const LCPEntry * e = 0;
+    for(size_t k = 0; k < numLCPKernels; k++)
+      if(supported(lcpKernels[k])) e = &lcpKernels[k];
+    return e;
+  }
+
+  // kernel in use: the best supported one unless set by setLCPKernel.
+  // it is selected on first use, so that lcp() also works when called
+  // from static initializers of other files that run before this one.
+  static const LCPEntry * lcpCurrent = 0;
+
+  static const LCPEntry * currentLCPKernel(){
+    static const LCPEntry * const best = selectLCPKernel();
+    return lcpCurrent ? lcpCurrent : best;
+  }
+
+  static size_t lcpFirstUse(const char * a, const char * b, size_t max){
+    return currentLCPKernel()->kernel(a, b, max);
+  }
+
+  static void lcp2FirstUse(const char * a, const char * b, const char * c,
+			   size_t max, size_t & la, size_t & lb){
+    currentLCPKernel()->kernel2(a, b, c, max, la, lb);
+  }
+
+  // initialized statically (before any dynamic initializer), and
+  // replaced by the selected kernel when this file is initialized
+  LCPKernel lcpLong = lcpFirstUse;
+  LCP2Kernel lcp2Long = lcp2FirstUse;
+
+  static bool initLCPKernel(){
+    if(lcpLong == lcpFirstUse){ // not set by setLCPKernel already
+      lcpLong = currentLCPKernel()->kernel;
+      lcp2Long = currentLCPKernel()->kernel2;
+    }
+    return true;
+  }
+  static const bool lcpInitialized = initLCPKernel();
+
+  bool setLCPKernel(const char * name){
+    for(size_t k = 0; k < numLCPKernels; k++){
+      if(strcmp(lcpKernels[k].name, name) == 0 && supported(lcpKernels[k])){
+	lcpCurrent = &lcpKernels[k];
+	lcpLong = lcpCurrent->kernel;
+	lcp2Long = lcpCurrent->kernel2;
+	return true;
+      }
+    }
+    return false;
+  }
+
+  const char * lcpKernelName(){
+    return currentLCPKernel()->name;
+  }
+
+  const char * const * lcpKernelNames(){
+    static const char * names[numLCPKernels + 1];
+    size_t m = 0;
+    for(size_t k = 0; k < numLCPKernels; k++)
+      if(supported(lcpKernels[k])) names[m++] = lcpKernels[k].name;
+    names[m] = 0;
+    return names;
+  }
+}
@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+// bgLCP.hpp
+//   longest common prefix of two substrings, compared a word
+//   or a vector register at a time
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_LCP_HPP__
+#define __LZBG_LCP_HPP__
+
+#include <stdint.h>
+#include <string.h>
+#include <cstddef>
+
+namespace LZBG {
+
+  typedef size_t (*LCPKernel)(const char * a, const char * b, size_t max);
+
+  typedef void (*LCP2Kernel)(const char * a, const char * b, const char * c,
+			     size_t max, size_t & la, size_t & lb);
+
+  // kernels for lcp() and lcp2() beyond the first 8 bytes, chosen at startup
+  // from byte, word, sse, avx2, avx512 as supported by the cpu.
+  extern LCPKernel lcpLong;
+  extern LCP2Kernel lcp2Long;
+
+  // use the kernel of the given name. return false if it is unknown
+  // or not supported by the cpu, and the kernel is not changed.
+  bool setLCPKernel(const char * name);
+
+  // name of the kernel in use
+  const char * lcpKernelName();
+
+  // names of the kernels supported by the cpu, 0 terminated
+  const char * const * lcpKernelNames();
+
+  // length of the longest common prefix of a[0..max-1] and b[0..max-1].
+  // the first word is compared inline, since most lcps are short.
+  inline size_t lcp(const char * a, const char * b, size_t max){
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if(max >= 8){
+      uint64_t x, y;
+      memcpy(&x, a, 8);
+      memcpy(&y, b, 8);
+      if(x != y) return __builtin_ctzll(x ^ y) >> 3;
+      return 8 + lcpLong(a + 8, b + 8, max - 8);
+    }
+#endif
+    size_t l = 0;
+    while(l < max && a[l] == b[l]) l++;
+    return l;
+  }
+
+  // la = lcp(a, c, max) and lb = lcp(b, c, max), computed in one pass
+  // over c: both are compared while they match c, then only the longer.
+  inline void lcp2(const char * a, const char * b, const char * c, size_t max,
+		   size_t & la, size_t & lb){
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if(max >= 8){
+      uint64_t x, y, z;
+      memcpy(&x, c, 8);
+      memcpy(&y, a, 8);
+      memcpy(&z, b, 8);
+      const uint64_t da = x ^ y, db = x ^ z;
+      if(da && db){
+	la = __builtin_ctzll(da) >> 3;
+	lb = __builtin_ctzll(db) >> 3;
+      } else if(da){
+	la = __builtin_ctzll(da) >> 3;
+	lb = 8 + lcpLong(b + 8, c + 8, max - 8);
+      } else if(db){
+	la = 8 + lcpLong(a + 8, c + 8, max - 8);
+	lb = __builtin_ctzll(db) >> 3;
+      } else {
+	lcp2Long(a + 8, b + 8, c + 8, max - 8, la, lb);
+	la += 8; lb += 8;
+      }
+      return;
+    }
+#endif
+    la = lcp(a, c, max);
+    lb = lcp(b, c, max);
+  }
+};
+#endif//__LZBG_LCP_HPP__
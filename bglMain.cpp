@@ -17,53 +17,52 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "bgCommon.hpp"
+#include "lzFile.hpp"
 #include <iostream>
 #include <fstream>
 
 using namespace LZBG;
 
-// this is a tail recursive call
-void peakElim(int p, int c, int *psv, int *nsv, int *sa){  
-  if(p < 0 || sa[p] < sa[c]){ 
-    psv[c] = p;
-  } else { // sa[p] > sa[c] // p is peak
-    nsv[p] = c;
-    peakElim(psv[p], c, psv, nsv, sa);
-  }
-}
-
 int main(int argc, char * argv[]){
 
-  std::string s;
+  Text s;
 
   // parse options and read/construct string & suffix array
-  int * sa = Init(argc, argv, s);
+  const saidx_t * sa = Init(argc, argv, s, READONLY_SA); // sa is not modified
   
   ////////////////////////////////////////////////////////////
   // calculate text order PSV, NSV using phi
   ////////////////////////////////////////////////////////////
   double t1 = gettime();
-  int n = s.size(), i;
-  int * rank = new int[n], * psv = new int[n], * nsv = new int[n];
+  savalue_t n = s.size(), i;
+  saidx_t * rank = new saidx_t[n], * psv = new saidx_t[n], * nsv = new saidx_t[n];
 
   double t2 = gettime();
-  for(i = 0; i < n; i++) rank[sa[i]] = i;
-  std::cout << "Time for rank: " << gettime() - t1 << std::endl;
-  t2 = gettime();
-  for(int i = 0; i < n; i++) nsv[i] = -1;
-  psv[0] = -1;
-  for(int i = 1; i < n; i++) peakElim(i-1, i, psv, nsv, sa);
-
-  std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+  saidx_t * arrays[] = { rank, psv, nsv };
+  if(loadArrays(s, "bgl", arrays, 3)){
+    std::cout << "Time for rank/pnsv (cache): " << gettime() - t2 << std::endl;
+  } else {
+    for(i = 0; i < n; i++) rank[sa[i]] = i;
+    std::cout << "Time for rank: " << gettime() - t1 << std::endl;
+    t2 = gettime();
+    pnsvLex(sa, n, psv, nsv);
+    std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+    saveArrays(s, "bgl", arrays, 3);
+  }
 
   ////////////////////////////////////////////////////////////
   // calculate LZ factorization from text order PSV, NSV
   ////////////////////////////////////////////////////////////
-  std::vector<std::pair<int,int> > lz;
+  std::vector<std::pair<savalue_t,savalue_t> > lz;
+  FileSink * out = outFile.empty() ? 0 : new FileSink(outFile, n);
+  CountSink sink(checkResult ? &lz : 0, out); // keep factors only for checking
   t2 = gettime();
-  lzFromLOPNSV(s, sa, rank, psv, nsv, lz);
+  lzFromLOPNSV(s.data(), n, sa, rank, psv, nsv, sink);
+  const bool written = !out || out->close(); // reports a failure
+  delete out;
+  if(!written) return 1;
   std::cout << "Time for lz: " << gettime() - t2 << std::endl;
-  std::cout << "# of lz factors: " << lz.size() << std::endl;
+  std::cout << "# of lz factors: " << sink.count << std::endl;
   std::cout << "Total: " << gettime() - t1 << std::endl;
   if(checkResult){
     std::string t = lz2str(lz);
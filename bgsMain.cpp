@@ -17,59 +17,55 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "bgCommon.hpp"
+#include "lzFile.hpp"
 #include <iostream>
 #include <fstream>
-#include <stack>
 
 using namespace LZBG;
 
-void pnsv(const int * sa, int n, int * psv, int * nsv){
-  int i;
-  std::stack<int,std::vector<int> > S;
-
-  for(i = 0; i < n; i++){
-    const int x = sa[i];
-    while(!S.empty() && sa[S.top()] > x){       // pop while new element is smaller
-      nsv[S.top()] = x; S.pop();
-    }
-    psv[i] = S.empty() ? -1 : sa[S.top()];
-    S.push(i);
-  }
-  while(!S.empty()){
-    nsv[S.top()] = -1; S.pop();
-  }
-
-}
-
 int main(int argc, char * argv[]){
 
-  std::string s;
+  Text s;
 
   // parse options and read/construct string & suffix array
-  int * sa = Init(argc, argv, s);
+  // sa is not modified, and not needed if rank and PSV/NSV are cached
+  saidx_t * sa = Init(argc, argv, s, LAZY_SA | READONLY_SA);
   
   ////////////////////////////////////////////////////////////
   // calculate text order PSV, NSV using phi
   ////////////////////////////////////////////////////////////
   double t1 = gettime();
-  int n = s.size(), i;
-  int * rank = new int[n], * psv = new int[n], * nsv = new int[n];
+  savalue_t n = s.size(), i;
+  saidx_t * rank = new saidx_t[n], * psv = new saidx_t[n], * nsv = new saidx_t[n];
 
   double t2 = gettime();
-  for(i = 0; i < n; i++) rank[sa[i]] = i;
-  std::cout << "Time for rank: " << gettime() - t1 << std::endl;
-  t2 = gettime();
-  pnsv(sa, n, psv, nsv);
-  std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+  saidx_t * arrays[] = { rank, psv, nsv };
+  if(loadArrays(s, "bgs", arrays, 3)){
+    std::cout << "Time for rank/pnsv (cache): " << gettime() - t2 << std::endl;
+  } else {
+    sa = loadSA(s, sa, READONLY_SA);
+    t1 = gettime();
+    for(i = 0; i < n; i++) rank[sa[i]] = i;
+    std::cout << "Time for rank: " << gettime() - t1 << std::endl;
+    t2 = gettime();
+    pnsvStack(sa, n, psv, nsv);
+    std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+    saveArrays(s, "bgs", arrays, 3);
+  }
 
   ////////////////////////////////////////////////////////////
   // calculate LZ factorization from text order PSV, NSV
   ////////////////////////////////////////////////////////////
-  std::vector<std::pair<int,int> > lz;
+  std::vector<std::pair<savalue_t,savalue_t> > lz;
+  FileSink * out = outFile.empty() ? 0 : new FileSink(outFile, n);
+  CountSink sink(checkResult ? &lz : 0, out); // keep factors only for checking
   t2 = gettime();
-  lzFromLOPNSVtp(s, sa, rank, psv, nsv, lz);
+  lzFromLOPNSVtp(s.data(), n, sa, rank, psv, nsv, sink);
+  const bool written = !out || out->close(); // reports a failure
+  delete out;
+  if(!written) return 1;
   std::cout << "Time for lz: " << gettime() - t2 << std::endl;
-  std::cout << "# of lz factors: " << lz.size() << std::endl;
+  std::cout << "# of lz factors: " << sink.count << std::endl;
   std::cout << "Total: " << gettime() - t1 << std::endl;
   if(checkResult){
     std::string t = lz2str(lz);
@@ -17,58 +17,52 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "bgCommon.hpp"
+#include "lzFile.hpp"
 #include <iostream>
 #include <fstream>
 
 using namespace LZBG;
 
-void peakElim(int j, int i, int * psv, int * nsv, int bot){
-  if(j < i){
-    psv[i] = j;
-    if(nsv[i] != bot){
-      peakElim(j, nsv[i], psv, nsv, bot);
-    }
-  } else {
-    nsv[j] = i;
-    if(psv[j] != bot){
-      peakElim(psv[j], i, psv, nsv, bot);
-    }
-  }  
-}
-
 int main(int argc, char * argv[]){
 
-  std::string s;
+  Text s;
 
   // parse options and read/construct string & suffix array
-  int * sa = Init(argc, argv, s);
+  saidx_t * sa = Init(argc, argv, s, LAZY_SA); // not needed if PSV/NSV are cached
   
   ////////////////////////////////////////////////////////////
   // calculate text order PSV, NSV using phi
   ////////////////////////////////////////////////////////////
   double t1 = gettime();
-  int n = s.size(), i;
-  // std::vector<int> phi(n), psv(n);
-  int * phi = new int[n], * psv = new int[n];
-  int * nsv = sa; // reuse suffix array
+  savalue_t n = s.size();
+  saidx_t * psv = new saidx_t[n]; // phi is computed into psv
+  saidx_t * nsv = sa; // reuse suffix array
 
   double t2 = gettime();
-  phi[sa[0]] = sa[n-1];
-  for(i = 1; i < n; i++) phi[sa[i]] = sa[i-1];
-  std::cout << "Time for phi: " << gettime() - t1 << std::endl;
-  t2 = gettime();
-  for(i = 0; i < n; i++) psv[i] = nsv[i] = -1;
-  for(i = 0; i < n; i++) peakElim(phi[i], i, psv, nsv, -1);
-  std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+  saidx_t * arrays[] = { psv, nsv };
+  if(loadArrays(s, "bgt", arrays, 2)){
+    std::cout << "Time for pnsv (cache): " << gettime() - t2 << std::endl;
+  } else {
+    loadSA(s, sa);
+    t1 = t2 = gettime();
+    pnsvTextFromSA(sa, n, psv);
+    std::cout << "Time for phi/pnsv: " << gettime() - t2 << std::endl;
+    saveArrays(s, "bgt", arrays, 2);
+  }
 
   ////////////////////////////////////////////////////////////
   // calculate LZ factorization from text order PSV, NSV
   ////////////////////////////////////////////////////////////
-  std::vector<std::pair<int,int> > lz;
+  std::vector<std::pair<savalue_t,savalue_t> > lz;
+  FileSink * out = outFile.empty() ? 0 : new FileSink(outFile, n);
+  CountSink sink(checkResult ? &lz : 0, out); // keep factors only for checking
   t2 = gettime();
-  lzFromTOPNSV(s, psv, nsv, lz);
+  lzFromTOPNSV(s.data(), n, psv, nsv, sink);
+  const bool written = !out || out->close(); // reports a failure
+  delete out;
+  if(!written) return 1;
   std::cout << "Time for lz: " << gettime() - t2 << std::endl;
-  std::cout << "# of lz factors: " << lz.size() << std::endl;
+  std::cout << "# of lz factors: " << sink.count << std::endl;
   std::cout << "Total: " << gettime() - t1 << std::endl;
   if(checkResult){
     std::string t = lz2str(lz);
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+// decodeMain.cpp
+//   decode a factor file written with -o
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bgCommon.hpp"
+#include "lzFile.hpp"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace LZBG;
+
+void print_usage_decode(char * argv []){
+  std::cout << "Usage  : " << argv[0] << " [options]" << std::endl
+	    << "Options: " << std::endl
+	    << "  -f iFile : factor file to decode" << std::endl
+	    << "  -o oFile : write the decoded text to oFile" << std::endl;
+}
+
+int main(int argc, char * argv[]){
+  int ch;
+  std::string inFile, textFile;
+  while ((ch = getopt(argc, argv, "f:o:h")) != -1) {
+    switch (ch) {
+    case 'f':
+      inFile = optarg;
+      break;
+    case 'o':
+      textFile = optarg;
+      break;
+    default:
+      print_usage_decode(argv);
+      exit(0);
+    }
+  }
+  if(inFile.empty()){ print_usage_decode(argv); exit(0); }
+
+  double t1 = gettime();
+  std::string t;
+  int64_t n = decodeFile(inFile, t);
+  if(n < 0){
+    std::cerr << "ERROR: failed to decode " << inFile << std::endl;
+    return 1;
+  }
+  std::cout << "Time for decoding: " << gettime() - t1 << std::endl;
+
+  struct stat st;
+  stat(inFile.c_str(), &st);
+  std::cout << "text length: " << n << std::endl;
+  std::cout << "bits per character: " << 8.0 * st.st_size / (n ? n : 1) << std::endl;
+  if(!textFile.empty()){
+    std::ofstream ofs(textFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write(t.data(), t.size());
+  }
+  return 0;
+}
@@ -27,11 +27,21 @@
 #ifndef _DIVSUFSORT_H
 #define _DIVSUFSORT_H 1
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
 
+/*- Datatypes -*/
+typedef int64_t saidx64_t;
+
+/*- Constants -*/
+/* number of elements of the bucket arrays used by divsufsort */
+#define DIVSUFSORT_BUCKET_SIZE (256 + 256 * 256)
+
+
 /*- Prototypes -*/
 
 /**
@@ -44,6 +54,14 @@ extern "C" {
 int
 divsufsort(const unsigned char *T, int *SA, int n);
 
+/**
+ * Same as divsufsort, using the given working memory for the buckets,
+ * so that it can be reused when many strings are sorted.
+ * @param bucket[0..DIVSUFSORT_BUCKET_SIZE-1] The bucket arrays.
+ */
+int
+divsufsort_bucket(const unsigned char *T, int *SA, int n, int *bucket);
+
 /**
  * Constructs the burrows-wheeler transformed string of a given string.
  * @param T[0..n-1] The input string.
@@ -55,6 +73,20 @@ divsufsort(const unsigned char *T, int *SA, int n);
 int
 divbwt(const unsigned char *T, unsigned char *U, int *A, int n);
 
+/**
+ * 64-bit versions of divsufsort and divbwt (built from divsufsort64.c),
+ * for strings of length 2^31 or more.
+ */
+int
+divsufsort64(const unsigned char *T, saidx64_t *SA, saidx64_t n);
+
+int
+divsufsort64_bucket(const unsigned char *T, saidx64_t *SA, saidx64_t n,
+                    saidx64_t *bucket);
+
+saidx64_t
+divbwt64(const unsigned char *T, unsigned char *U, saidx64_t *A, saidx64_t n);
+
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// externalMain.cpp
+//   lz factorization with the suffix array on disk (lzExternal)
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bgCommon.hpp"
+#include "bgExternal.hpp"
+#include "lzFile.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace LZBG;
+
+void print_usage_external(char * argv []){
+  std::cout << "Usage  : " << argv[0] << " [options]" << std::endl
+	    << "Options: " << std::endl
+	    << "  -f iFile  : file to process" << std::endl
+	    << "  -M MB     : memory for the arrays besides the text (default: 256)," << std::endl
+	    << "              at least 0.25 + 128 * sqrt(w * N) / 2^20 for N characters" << std::endl
+	    << "              and w bytes per index (w = " << sizeof(saidx_t) << "; e.g. 8.25 for N = 1GiB" << std::endl
+	    << "              with w = 4), so that each range has a 4KB buffer" << std::endl
+	    << "  -T prefix : prefix of the temporary files (default: iFile + '.ext')" << std::endl
+	    << "  -g        : check if resulting factorization produces input string" << std::endl
+	    << "  -o oFile  : write the factorization to oFile (see lzFile.hpp)" << std::endl
+	    << "  -t num    : number of threads for constructing a missing suffix array" << std::endl
+	    << "              (requires OpenMP, default: all cores)" << std::endl
+	    << "the suffix array is read from the cache iFile + '.sa' (as with -x of the other" << std::endl
+	    << "programs, '.sa40', '.sa64' for 40 and 64 bit indices), which is created if needed." << std::endl;
+}
+
+static void printStats(const char * name, const PhaseStats & st){
+  std::cout << "Time for " << name << ": " << st.time << std::endl;
+  std::cout << "I/O for " << name << ": " << st.read / 1048576.0 << " MB read, "
+	    << st.written / 1048576.0 << " MB written ("
+	    << st.inBlocks << " / " << st.outBlocks << " disk blocks in / out)" << std::endl;
+}
+
+int main(int argc, char * argv[]){
+  int ch;
+  size_t memory = 256;
+  std::string inFile, tmpPrefix;
+  while ((ch = getopt(argc, argv, "f:M:T:go:t:h")) != -1) {
+    switch (ch) {
+    case 'f':
+      inFile = optarg;
+      break;
+    case 'M':
+      memory = atol(optarg);
+      break;
+    case 'T':
+      tmpPrefix = optarg;
+      break;
+    case 'g':
+      checkResult = true;
+      break;
+    case 'o':
+      outFile = optarg;
+      break;
+    case 't':
+      setThreads(atoi(optarg));
+      break;
+    default:
+      print_usage_external(argv);
+      exit(0);
+    }
+  }
+  if(inFile.empty() || memory == 0){
+    print_usage_external(argv);
+    exit(0);
+  }
+  if(tmpPrefix.empty()) tmpPrefix = inFile + ".ext";
+
+  double t1 = gettime();
+  Text s;
+  if(!s.mapFile(inFile)) s.readFile(inFile);
+  if(s.size() > static_cast<size_t>(IndexLimit<saidx_t>::max)){
+    std::cerr << "ERROR: The file size is too big for " << sizeof(saidx_t) * 8
+	      << " bit indices. Cannot process." << std::endl;
+    exit(1);
+  }
+  if((memory << 20) < externalMinMemory(s.size())){
+    std::cerr << "ERROR: -M " << memory << " is too small for the text: at least "
+	      << externalMinMemory(s.size()) / 1048576.0 << " MB are needed." << std::endl;
+    exit(1);
+  }
+  const int fd = openSA(s, inFile);
+  if(fd < 0) return 1;
+  double t2 = gettime();
+  std::cout << "Time for sa: " << t2 - t1 << std::endl;
+
+  std::vector<std::pair<savalue_t,savalue_t> > lz;
+  FileSink * out = outFile.empty() ? 0 : new FileSink(outFile, s.size());
+  CountSink sink(checkResult ? &lz : 0, out); // keep factors only for checking
+  PhaseStats stats[2];
+  const bool ok = lzExternal(s, fd, memory << 20, tmpPrefix, sink, stats);
+  const bool written = !out || out->close(); // reports a failure
+  delete out;
+  if(!ok || !written) return 1;
+
+  printStats("pnsv", stats[0]);
+  printStats("lz", stats[1]);
+  std::cout << "text length: " << s.size() << std::endl;
+  std::cout << "# of lz factors: " << sink.count << std::endl;
+  std::cout << "Total: " << gettime() - t1 << std::endl;
+  if(checkResult){
+    if(s != lz2str(lz)) std::cerr << "CHECK: ERROR: mismatch" << std::endl;
+    else std::cerr << "CHECK: OK" << std::endl;
+  }
+  return 0;
+}
@@ -18,61 +18,58 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "bgCommon.hpp"
+#include "lzFile.hpp"
 #include <iostream>
 #include <fstream>
 
-#define PSV(i) pnsv[(i << 1)]
-#define NSV(i) pnsv[(i << 1)+1]
-
 using namespace LZBG;
 
-void peakElim(int j, int i, int * pnsv, int bot){
-  if(j < i){
-    PSV(i) = j;
-    if(NSV(i) != bot){
-      peakElim(j, NSV(i), pnsv, bot);
-    }
-  } else {
-    NSV(j) = i;
-    if(PSV(j) != bot){
-      peakElim(PSV(j), i, pnsv, bot);
-    }
-  }  
-}
-
 int main(int argc, char * argv[]){
 
-  std::string s;
+  Text s;
 
   // parse options and read/construct string & suffix array
-  int * sa = Init(argc, argv, s, DOUBLE_SA);
+  saidx_t * sa = Init(argc, argv, s, DOUBLE_SA | LAZY_SA); // not needed if PNSV is cached
   
   ////////////////////////////////////////////////////////////
   // calculate text order PSV, NSV using phi
   ////////////////////////////////////////////////////////////
   double t1 = gettime();
-  int n = s.size(), i;
+  savalue_t n = s.size(), i;
 
-  int * phi = new int[n];
-  int * pnsv = sa; // reuse suffix array
+  saidx_t * pnsv = sa; // reuse suffix array
 
   double t2 = gettime();
-  phi[sa[0]] = sa[n-1];
-  for(i = 1; i < n; i++) phi[sa[i]] = sa[i-1];
-  std::cout << "Time for phi: " << gettime() - t1 << std::endl;
-  t2 = gettime();
-  for(i = 0; i < 2*n; i++) pnsv[i] = -1;
-  for(i = 0; i < n; i++) peakElim(phi[i], i, pnsv, -1);
-  std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+  saidx_t * arrays[] = { pnsv, pnsv + n };
+  if(loadArrays(s, "ibgt", arrays, 2)){
+    std::cout << "Time for pnsv (cache): " << gettime() - t2 << std::endl;
+  } else {
+    loadSA(s, sa, DOUBLE_SA);
+    t1 = t2 = gettime();
+    saidx_t * phi = new saidx_t[n];
+    phi[sa[0]] = sa[n-1];
+    for(i = 1; i < n; i++) phi[sa[i]] = sa[i-1];
+    std::cout << "Time for phi: " << gettime() - t1 << std::endl;
+    t2 = gettime();
+    pnsvText(phi, n, pnsv);
+    std::cout << "Time for pnsv: " << gettime() - t2 << std::endl;
+    delete [] phi;
+    saveArrays(s, "ibgt", arrays, 2);
+  }
 
   ////////////////////////////////////////////////////////////
   // calculate LZ factorization from text order PSV, NSV
   ////////////////////////////////////////////////////////////
-  std::vector<std::pair<int,int> > lz;
+  std::vector<std::pair<savalue_t,savalue_t> > lz;
+  FileSink * out = outFile.empty() ? 0 : new FileSink(outFile, n);
+  CountSink sink(checkResult ? &lz : 0, out); // keep factors only for checking
   t2 = gettime();
-  lzFromTOPNSV(s, pnsv, lz);
+  lzFromTOPNSV(s.data(), n, pnsv, sink);
+  const bool written = !out || out->close(); // reports a failure
+  delete out;
+  if(!written) return 1;
   std::cout << "Time for lz: " << gettime() - t2 << std::endl;
-  std::cout << "# of lz factors: " << lz.size() << std::endl;
+  std::cout << "# of lz factors: " << sink.count << std::endl;
   std::cout << "Total: " << gettime() - t1 << std::endl;
   if(checkResult){
     std::string t = lz2str(lz);
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzAccess.cpp
+//   random access to the text of an lz factorization
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include "lzAccess.hpp"
+
+namespace LZBG {
+
+  LZIndex::LZIndex(int maxDepth)
+    : depthLimit(std::min(std::max(maxDepth, 1), 255)), start(1, 0), shift(0), cap(0){}
+
+  ////////////////////////////////////////////////////////////
+  // adding factors
+  ////////////////////////////////////////////////////////////
+  void LZIndex::factor(int64_t len, int64_t prev){
+    const int64_t p = start.back();
+    const size_t off = text.size();
+    int d = 0;
+    if(len == 0){
+      text.push_back(static_cast<char>(prev));
+      len = 1;
+    } else {
+      // the part of the source after p repeats the part before p
+      d = 1 + maxDepth(prev, std::min(prev + len, p));
+      if(d > depthLimit){
+	const int64_t w = std::min(len, p - prev);
+	text.resize(off + len);
+	extract(prev, w, &text[off]);
+	for(int64_t k = w; k < len; k += w) // w is a multiple of the period p - prev
+	  memcpy(&text[off + k], &text[off], std::min(w, len - k));
+	d = 0;
+      }
+    }
+    if(d == 0 && !src.empty() && src.back() < 0){
+      // explicit text follows that of the last factor: extend it
+      start.back() += len;
+      return;
+    }
+    const size_t f = src.size();
+    src.push_back(d == 0 ? ~int64_t(off) : prev);
+    start.push_back(p + len);
+
+    // set depth of f in the segment tree (leaves at cap + f),
+    // doubling the capacity if it is full
+    if(f == cap){
+      const size_t ncap = std::max<size_t>(1024, 2 * cap);
+      std::vector<uint8_t> t(2 * ncap, 0);
+      std::copy(depth.begin() + cap, depth.begin() + 2 * cap, t.begin() + ncap);
+      for(size_t k = ncap - 1; k > 0; k--) t[k] = std::max(t[2 * k], t[2 * k + 1]);
+      depth.swap(t);
+      cap = ncap;
+    }
+    for(size_t k = cap + f; k > 0; k >>= 1){
+      if(depth[k] >= d) break;
+      depth[k] = d;
+    }
+  }
+
+  // maximum depth of the factors containing T[b..e-1]
+  int LZIndex::maxDepth(int64_t b, int64_t e) const {
+    size_t l = find(b) + cap, r = find(e - 1) + cap + 1;
+    int d = 0;
+    for(; l < r; l >>= 1, r >>= 1){
+      if(l & 1) d = std::max<int>(d, depth[l++]);
+      if(r & 1) d = std::max<int>(d, depth[--r]);
+    }
+    return d;
+  }
+
+  void LZIndex::finish(){
+    const int64_t n = length();
+    const size_t z = factors();
+    std::vector<uint8_t>().swap(depth);
+    cap = 0;
+    if(z == 0) return;
+    // about one sample per factor
+    for(shift = 0; (n >> shift) > int64_t(z); shift++);
+    sample.resize((n >> shift) + 2);
+    size_t f = 0;
+    for(size_t b = 0; b < sample.size(); b++){
+      const int64_t i = std::min(int64_t(b) << shift, n - 1);
+      while(start[f + 1] <= i) f++;
+      sample[b] = f;
+    }
+  }
+
+  ////////////////////////////////////////////////////////////
+  // extraction
+  ////////////////////////////////////////////////////////////
+
+  // factor containing text position i
+  size_t LZIndex::find(int64_t i) const {
+    std::vector<int64_t>::const_iterator b = start.begin(), e = start.end() - 1;
+    if(!sample.empty()){
+      b = start.begin() + sample[i >> shift];
+      e = start.begin() + sample[(i >> shift) + 1] + 1;
+    }
+    return std::upper_bound(b, e, i) - start.begin() - 1;
+  }
+
+  // T[i..i+len-1], within factor f
+  void LZIndex::get(size_t f, int64_t i, int64_t len, char * out) const {
+    const int64_t o = i - start[f];
+    if(src[f] < 0){
+      memcpy(out, &text[~src[f] + o], len);
+      return;
+    }
+    const int64_t prev = src[f], d = start[f] - prev;
+    if(d >= start[f + 1] - start[f]){
+      extract(prev + o, len, out);
+      return;
+    }
+    // self-overlapping: period d from prev. extract one period
+    // starting at o, and repeat it with copies of doubling length.
+    const int64_t r = o % d, m1 = std::min(len, d - r), m2 = std::min(len - m1, r);
+    extract(prev + r, m1, out);
+    if(m2 > 0) extract(prev, m2, out + m1);
+    for(int64_t w = m1 + m2; w < len; w *= 2)
+      memcpy(out + w, out, std::min(w, len - w));
+  }
+
+  int64_t LZIndex::extract(int64_t i, int64_t len, char * out) const {
+    const int64_t n = length();
+    if(i < 0 || i >= n || len <= 0) return 0;
+    len = std::min(len, n - i);
+    size_t f = find(i);
+    for(int64_t k = 0; k < len; f++){
+      const int64_t c = std::min(len - k, start[f + 1] - (i + k));
+      get(f, i + k, c, out + k);
+      k += c;
+    }
+    return len;
+  }
+
+  std::string LZIndex::substr(int64_t i, int64_t len) const {
+    std::string s;
+    if(i >= 0 && i < length() && len > 0){
+      s.resize(std::min(len, length() - i));
+      extract(i, s.size(), &s[0]);
+    }
+    return s;
+  }
+}
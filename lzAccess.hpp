@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzAccess.hpp
+//   random access to the text of an lz factorization
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+// A character in a factor is found by following its previous occurrence
+// to the factor containing it, and so on, until a literal is reached.
+// The depth of a factor is the length of the longest such chain for its
+// characters (a literal has depth 0). When the factors are added, a factor
+// whose depth would exceed maxDepth is decoded and its text is stored
+// (depth 0), so that a character is found after at most maxDepth steps.
+// Self-overlapping factors are periodic, and are resolved in one step.
+// Runs of literals and stored factors are kept as single factors, so that
+// their text is copied at once.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_ACCESS_HPP__
+#define __LZBG_ACCESS_HPP__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "bgCommon.hpp"
+
+namespace LZBG {
+
+  // index over the factors passed to it (in text order, as to any sink)
+  class LZIndex : public Sink {
+  public:
+    LZIndex(int maxDepth = 16);
+    void factor(int64_t len, int64_t prev);
+    // call after the last factor: builds the sampled search structure
+    // for the factor starts and frees the memory used for adding factors.
+    void finish();
+
+    // length of the text
+    int64_t length() const { return start.back(); }
+    // number of factors in the index
+    // (consecutive literals and stored factors are merged)
+    size_t factors() const { return src.size(); }
+    // number of characters stored explicitly (literals and cut chains)
+    size_t explicitChars() const { return text.size(); }
+
+    // extract T[i..i+len-1] (clipped to the text) into out.
+    // return the number of characters extracted.
+    int64_t extract(int64_t i, int64_t len, char * out) const;
+    std::string substr(int64_t i, int64_t len) const;
+  private:
+    size_t find(int64_t i) const;
+    void get(size_t f, int64_t i, int64_t len, char * out) const;
+    int maxDepth(int64_t b, int64_t e) const;
+
+    int depthLimit;
+    std::vector<int64_t> start;  // start[f]: text position of factor f, start[z] = n
+    std::vector<int64_t> src;    // previous occurrence, or ~(offset in text) if explicit
+    std::string text;            // characters of the explicit factors
+    // search: factor containing i is in [sample[i >> shift], sample[(i >> shift) + 1]]
+    std::vector<int64_t> sample;
+    int shift;
+    // while adding: depths of the factors in a segment tree for range maxima
+    std::vector<uint8_t> depth;
+    size_t cap;
+  };
+};
+#endif//__LZBG_ACCESS_HPP__
@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzFile.cpp
+//   compact binary file format for lz factorizations
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <cstring>
+#include "lzFile.hpp"
+
+namespace LZBG {
+
+  static const size_t BUFSIZE = 1 << 20;
+
+  ////////////////////////////////////////////////////////////
+  // writer
+  ////////////////////////////////////////////////////////////
+  EncodeSink::EncodeSink(int64_t n) : pos(0){
+    buf.reserve(BUFSIZE + 32);
+    buf.insert(buf.end(), LZFILE_MAGIC, LZFILE_MAGIC + 4);
+    buf.push_back(static_cast<char>(LZFILE_VERSION));
+    for(int k = 0; k < 8; k++) buf.push_back(static_cast<char>(uint64_t(n) >> (8 * k)));
+  }
+
+  void EncodeSink::factor(int64_t len, int64_t prev){
+    if(len == 0){
+      literals.push_back(static_cast<char>(prev));
+      pos++;
+      // a long run is written as several runs, not kept in memory as a whole
+      if(literals.size() >= BUFSIZE) flushLiterals();
+    } else {
+      flushLiterals();
+      putVarint(uint64_t(len) << 1 | 1);
+      putVarint(uint64_t(pos - prev));
+      pos += len;
+      if(buf.size() >= BUFSIZE) flushBuffer();
+    }
+  }
+
+  void EncodeSink::finish(){
+    flushLiterals();
+  }
+
+  void EncodeSink::flushLiterals(){
+    if(literals.empty()) return;
+    putVarint(uint64_t(literals.size()) << 1);
+    buf.insert(buf.end(), literals.begin(), literals.end());
+    literals.clear();
+    if(buf.size() >= BUFSIZE) flushBuffer();
+  }
+
+  void EncodeSink::putVarint(uint64_t x){
+    while(x >= 0x80){
+      buf.push_back(static_cast<char>(x | 0x80));
+      x >>= 7;
+    }
+    buf.push_back(static_cast<char>(x));
+  }
+
+  FileSink::FileSink(const std::string & fileName, int64_t n)
+    : EncodeSink(n < 0 ? 0 : n), fileName(fileName),
+      ofs(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+      patchLength(n < 0), ok(ofs.is_open()){
+    if(!ok) std::cerr << "failed to open file: " << fileName << std::endl;
+  }
+
+  FileSink::~FileSink(){
+    close();
+  }
+
+  bool FileSink::close(){
+    if(!ofs.is_open()) return ok;
+    finish();
+    flushBuffer();
+    if(patchLength){
+      char n[8];
+      for(int k = 0; k < 8; k++) n[k] = static_cast<char>(uint64_t(length()) >> (8 * k));
+      ofs.seekp(5);
+      ofs.write(n, 8);
+    }
+    ofs.close();
+    if(ofs.fail()){ // any write, seek or the close failed
+      std::cerr << "failed to write file: " << fileName << std::endl;
+      ok = false;
+    }
+    return ok;
+  }
+
+  void FileSink::flushBuffer(){
+    if(!buf.empty() && ofs.is_open()) ofs.write(&buf[0], buf.size());
+    buf.clear();
+  }
+
+  ////////////////////////////////////////////////////////////
+  // reader
+  ////////////////////////////////////////////////////////////
+  FileReader::FileReader(const std::string & fileName)
+    : ifs(fileName.c_str(), std::ios::in | std::ios::binary), ok(false),
+      n(0), pos(0), runLeft(0), buf(BUFSIZE), bufPos(0), bufLen(0){
+    if(!ifs){
+      std::cerr << "failed to read file: " << fileName << std::endl;
+      return;
+    }
+    uint8_t header[13];
+    for(int k = 0; k < 13; k++){
+      if(!getByte(header[k])) break;
+      if(k == 12) ok = true;
+    }
+    if(!ok || memcmp(header, LZFILE_MAGIC, 4) != 0 || header[4] != LZFILE_VERSION){
+      std::cerr << "not a factor file (or unsupported version): " << fileName << std::endl;
+      ok = false;
+      return;
+    }
+    uint64_t x = 0;
+    for(int k = 0; k < 8; k++) x |= uint64_t(header[5 + k]) << (8 * k);
+    n = static_cast<int64_t>(x);
+  }
+
+  bool FileReader::fill(){
+    ifs.read(&buf[0], buf.size());
+    bufLen = ifs.gcount();
+    bufPos = 0;
+    return bufLen > 0;
+  }
+
+  bool FileReader::getByte(uint8_t & c){
+    if(bufPos == bufLen && !fill()) return false;
+    c = static_cast<uint8_t>(buf[bufPos++]);
+    return true;
+  }
+
+  bool FileReader::getVarint(uint64_t & x){
+    uint8_t c;
+    x = 0;
+    for(int shift = 0; shift < 64; shift += 7){
+      if(!getByte(c)) return false;
+      x |= uint64_t(c & 0x7f) << shift;
+      if(!(c & 0x80)) return true;
+    }
+    return false;
+  }
+
+  bool FileReader::next(int64_t & len, int64_t & prev){
+    if(!ok || pos >= n) return false;
+    if(runLeft == 0){
+      uint64_t token, dist;
+      if(!getVarint(token)){ ok = false; return false; }
+      if(token & 1){
+	len = static_cast<int64_t>(token >> 1);
+	if(!getVarint(dist) || len <= 0 || dist == 0 || int64_t(dist) > pos || len > n - pos){
+	  ok = false; return false;
+	}
+	prev = pos - static_cast<int64_t>(dist);
+	pos += len;
+	return true;
+      }
+      runLeft = token >> 1;
+      if(runLeft == 0 || int64_t(runLeft) > n - pos){ ok = false; return false; }
+    }
+    uint8_t c;
+    if(!getByte(c)){ ok = false; return false; }
+    runLeft--;
+    len = 0;
+    prev = static_cast<char>(c); // as passed to the sink: (0, T[p])
+    pos++;
+    return true;
+  }
+
+  int64_t readFactors(const std::string & fileName, Sink & sink){
+    FileReader r(fileName);
+    int64_t len, prev;
+    while(r.next(len, prev)) sink.factor(len, prev);
+    return r.good() ? r.length() : -1;
+  }
+
+  int64_t decodeFile(const std::string & fileName, std::string & t){
+    FileReader r(fileName);
+    if(!r.good()) return -1;
+    t.assign(r.length(), '\0');
+    DecodeSink d(t.empty() ? 0 : &t[0], r.length());
+    int64_t len, prev;
+    while(r.next(len, prev)) d.DecodeSink::factor(len, prev);
+    if(!r.good() || !d.good() || d.size() != r.length()) return -1;
+    return r.length();
+  }
+}
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzFile.hpp
+//   compact binary file format for lz factorizations
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+// file format (all integers little endian):
+//   header: "LZBG" version(1 byte) n(8 bytes, length of the text)
+//   then a sequence of tokens, until n characters are encoded:
+//     varint(k << 1)       followed by k bytes: run of k literals
+//     varint(len << 1 | 1) varint(p - prev): factor of length len starting
+//                          at text position p, copied from prev < p
+//   varint: 7 bits per byte, least significant first,
+//           high bit set on all but the last byte.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_FILE_HPP__
+#define __LZBG_FILE_HPP__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "bgCommon.hpp"
+
+namespace LZBG {
+
+  static const char LZFILE_MAGIC[4] = { 'L', 'Z', 'B', 'G' };
+  static const uint8_t LZFILE_VERSION = 1;
+
+  // sink that encodes the factors of a text of length n in memory,
+  // in the format above. the encoding is complete after finish().
+  class EncodeSink : public Sink {
+  public:
+    EncodeSink(int64_t n);
+    virtual ~EncodeSink(){}
+    void factor(int64_t len, int64_t prev);
+    void finish();
+    // the encoded factors (FileSink: those not yet written)
+    std::vector<char> & data(){ return buf; }
+    // length of the text encoded so far
+    int64_t length() const { return pos; }
+  protected:
+    // called when buf has grown to the buffer size: FileSink writes it out
+    virtual void flushBuffer(){}
+    std::vector<char> buf;    // output buffer
+  private:
+    void flushLiterals();
+    void putVarint(uint64_t x);
+    int64_t pos;              // text position of the next factor
+    std::string literals;     // pending run of literals (up to 1MB)
+  };
+
+  // sink that writes the factors of a text of length n to a file.
+  // the file is complete when the sink is destroyed or closed.
+  // close() returns false (with a message) if the file could not be
+  // opened or written completely.
+  // if n < 0 (not known in advance, e.g. for a stream), the length of
+  // the factorized text is written into the header when closed.
+  class FileSink : public EncodeSink {
+  public:
+    FileSink(const std::string & fileName, int64_t n);
+    ~FileSink();
+    bool close();
+    bool good() const { return ok && !ofs.fail(); }
+  protected:
+    void flushBuffer();
+  private:
+    std::string fileName;
+    std::ofstream ofs;
+    bool patchLength;
+    bool ok;
+  };
+
+  // reads a factor file written by FileSink
+  class FileReader {
+  public:
+    FileReader(const std::string & fileName);
+    // false if the file could not be opened or has an invalid header
+    bool good() const { return ok; }
+    // length of the text
+    int64_t length() const { return n; }
+    // next factor as passed to the sink. return false at the end of the
+    // factorization (or if the file is truncated or corrupt: see good())
+    bool next(int64_t & len, int64_t & prev);
+  private:
+    bool fill();
+    bool getByte(uint8_t & c);
+    bool getVarint(uint64_t & x);
+    std::ifstream ifs;
+    bool ok;
+    int64_t n, pos;
+    uint64_t runLeft;         // literals left in the current run
+    std::vector<char> buf;
+    size_t bufPos, bufLen;
+  };
+
+  // pass all factors of a file to sink.
+  // return the length of the text, or -1 on error.
+  int64_t readFactors(const std::string & fileName, Sink & sink);
+
+  // decode the factors of a file into t, allocated at once.
+  // return the length of the text, or -1 on error.
+  int64_t decodeFile(const std::string & fileName, std::string & t);
+};
+#endif//__LZBG_FILE_HPP__
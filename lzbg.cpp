@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzbg.cpp
+//   library interface for lz factorization
+//   BGS, iBGS, BGL, iBGL, BGT, iBGT, OG, iOG
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lzbg.hpp"
+#include "divsufsort.h"
+
+namespace LZBG {
+
+  // n elements of b, which is never shrunk. when it has to grow,
+  // the old contents are dropped instead of being copied.
+  template<class T>
+  static T * buffer(std::vector<char> & b, size_t n){
+    if(b.size() < n * sizeof(T)){
+      std::vector<char>().swap(b);
+      b.resize(n * sizeof(T));
+    }
+    return b.empty() ? 0 : reinterpret_cast<T *>(&b[0]);
+  }
+
+  template<class Index>
+  static int factorize(const uint8_t * T, size_t n, Variant v, Sink & sink,
+		       Workspace & ws){
+    typedef typename IndexValue<Index>::type V;
+    const V len = static_cast<V>(n);
+    const char * s = reinterpret_cast<const char *>(T);
+    const bool doubleSA = (v == IBGT || v == IOG);
+    V i;
+
+    ////////////////////////////////////////////////////////////
+    // suffix array
+    ////////////////////////////////////////////////////////////
+    const size_t sasize = doubleSA ? 2 * n : n;
+    Index * sa = buffer<Index>(ws.sa, sasize);
+    // 64 bit buckets suffice for both divsufsort and divsufsort64
+    int64_t * bucket = buffer<int64_t>(ws.bucket, DIVSUFSORT_BUCKET_SIZE);
+    if(divsufsort(T, sa, len, sasize, bucket) != 0) return -2;
+
+    ////////////////////////////////////////////////////////////
+    // PSV, NSV (LPF, PrevOcc for OG) and lz
+    ////////////////////////////////////////////////////////////
+    switch(v){
+    case BGS: case BGL: case IBGS: case IBGL: {
+      Index * rank = buffer<Index>(ws.aux1, n);
+      for(i = 0; i < len; i++) rank[sa[i]] = i;
+      Index * psv = buffer<Index>(ws.aux2, 2 * n), * nsv = psv + n, * pnsv = psv;
+      if(v == BGS){
+	pnsvStack(sa, len, psv, nsv);
+	lzFromLOPNSVtp(s, len, sa, rank, psv, nsv, sink);
+      } else if(v == IBGS){
+	pnsvStack(sa, len, pnsv);
+	lzFromLOPNSVtp(s, len, sa, rank, pnsv, sink);
+      } else if(v == BGL){
+	pnsvLex(sa, len, psv, nsv);
+	lzFromLOPNSV(s, len, sa, rank, psv, nsv, sink);
+      } else {
+	pnsvLex(sa, len, pnsv);
+	lzFromLOPNSV(s, len, sa, rank, pnsv, sink);
+      }
+      break;
+    }
+    case BGT: {
+      Index * psv = buffer<Index>(ws.aux1, n), * nsv = sa; // reuse suffix array
+      pnsvTextFromSA(sa, len, psv);
+      lzFromTOPNSV(s, len, psv, nsv, sink);
+      break;
+    }
+    case IBGT: {
+      Index * phi = buffer<Index>(ws.aux1, n);
+      phi[sa[0]] = sa[len-1];
+      for(i = 1; i < len; i++) phi[sa[i]] = sa[i-1];
+      Index * pnsv = sa; // reuse suffix array
+      pnsvText(phi, len, pnsv);
+      lzFromTOPNSV(s, len, pnsv, sink);
+      break;
+    }
+    case OG: case IOG: {
+      Index * phi = buffer<Index>(ws.aux1, n);
+      phi[sa[0]] = -1;
+      for(i = 1; i < len; i++) phi[sa[i]] = sa[i-1];
+      if(v == OG){
+	Index * lps = sa, * prevOcc = buffer<Index>(ws.aux2, n); // reuse suffix array
+	lpfPrevOcc(s, len, phi, lps, prevOcc);
+	lzFromTOLPFPO(s, len, lps, prevOcc, sink);
+      } else {
+	Index * lpspo = sa; // reuse suffix array
+	lpfPrevOcc(s, len, phi, lpspo);
+	lzFromTOLPFPO(s, len, lpspo, sink);
+      }
+      break;
+    }
+    }
+    return 0;
+  }
+
+  int factorize(const uint8_t * T, size_t n, Variant v, Sink & sink,
+		Workspace & ws){
+    if(n == 0) return 0;
+    if(n <= static_cast<size_t>(IndexLimit<int32_t>::max))
+      return factorize<int32_t>(T, n, v, sink, ws);
+    if(n <= static_cast<size_t>(IndexLimit<uint40_t>::max))
+      return factorize<uint40_t>(T, n, v, sink, ws);
+    if(n <= static_cast<size_t>(IndexLimit<int64_t>::max))
+      return factorize<int64_t>(T, n, v, sink, ws);
+    return -1;
+  }
+
+  int factorize(const uint8_t * T, size_t n, Variant v, Sink & sink){
+    Workspace ws;
+    return factorize(T, n, v, sink, ws);
+  }
+
+  template<class Index>
+  static size_t workingMemory(size_t n, Variant v){
+    size_t m = DIVSUFSORT_BUCKET_SIZE * sizeof(int64_t);
+    switch(v){
+    case BGS: case BGL: case IBGS: case IBGL:
+      m += 4 * n * sizeof(Index); // sa, rank, psv/nsv or pnsv
+      break;
+    case BGT:
+      m += 2 * n * sizeof(Index); // sa (nsv), phi/psv
+      break;
+    default:
+      m += 3 * n * sizeof(Index); // 2N sa (pnsv, lpspo) or sa, prevOcc, and phi
+      break;
+    }
+    // divsufsort64 into a temporary array (see divsufsort)
+    if(sizeof(Index) == sizeof(uint40_t) && v != IBGT && v != IOG)
+      m += n * sizeof(int64_t);
+    return m;
+  }
+
+  size_t workingMemory(size_t n, Variant v){
+    if(n == 0) return 0;
+    if(n <= static_cast<size_t>(IndexLimit<int32_t>::max))
+      return workingMemory<int32_t>(n, v);
+    if(n <= static_cast<size_t>(IndexLimit<uint40_t>::max))
+      return workingMemory<uint40_t>(n, v);
+    return workingMemory<int64_t>(n, v);
+  }
+}
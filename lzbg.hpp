@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+// lzbg.hpp
+//   library interface for lz factorization
+//   BGS, iBGS, BGL, iBGL, BGT, iBGT, OG, iOG
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __LZBG_HPP__
+#define __LZBG_HPP__
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include "bgCommon.hpp"
+
+namespace LZBG {
+
+  enum Variant {
+    BGS, BGL, BGT, IBGS, IBGL, IBGT, OG, IOG
+  };
+
+  // working memory for factorize().
+  // owned by the caller, and can be reused for subsequent calls
+  // so that memory is not reallocated for each input.
+  // arrays are raw memory since the index type depends on the input length.
+  // the arrays only grow, so that after the largest input has been
+  // processed, no memory is allocated (or first touched) for the others.
+  struct Workspace {
+    std::vector<char> sa;     // suffix array (2N indices for iBGT, iOG)
+    std::vector<char> aux1;   // rank, phi, phi/psv (BGT)
+    std::vector<char> aux2;   // psv/nsv, pnsv, prevOcc
+    std::vector<char> bucket; // buckets of divsufsort
+  };
+
+  // compute the lz factorization of T[0..n-1] with the given variant
+  // and pass the factors to sink (Sink, VectorSink: see bgCommon.hpp)
+  // as they are computed. reentrant: no global state is used.
+  // 32 bit indices are used if n < 2^31, 40 bit indices if n < 2^40,
+  // and 64 bit indices otherwise.
+  // return 0 if no error occurred, -1 if n is too large, -2 if
+  // suffix array construction failed.
+  int factorize(const uint8_t * T, size_t n, Variant v, Sink & sink,
+		Workspace & ws);
+
+  // same as above, using temporary working memory
+  int factorize(const uint8_t * T, size_t n, Variant v, Sink & sink);
+
+  // bytes of working memory used by factorize() for a text of length n
+  // (at most; the text itself is not included). e.g., 16*N + 0.5MB for
+  // iBGS with 32 bit indices.
+  size_t workingMemory(size_t n, Variant v);
+};
+#endif//__LZBG_HPP__
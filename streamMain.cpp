@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+// streamMain.cpp
+//   lz factorization of a stream with a bounded window (lzStream)
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2012 Hideo Bannai & Keisuke Goto
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "bgCommon.hpp"
+#include "lzFile.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace LZBG;
+
+// passes the factors of a window on with the positions in the stream
+class OffsetSink : public Sink {
+public:
+  OffsetSink(Sink & next) : offset(0), next(next){}
+  void factor(int64_t len, int64_t prev){
+    next.factor(len, len > 0 ? prev + offset : prev);
+  }
+  int64_t offset;
+private:
+  Sink & next;
+};
+
+// read n bytes from fd into buf, or less at the end of the input
+static int32_t readBlock(int fd, char * buf, int32_t n){
+  int32_t r = 0;
+  while(r < n){
+    ssize_t k = read(fd, buf + r, n - r);
+    if(k < 0 && errno == EINTR) continue;
+    if(k <= 0) break;
+    r += k;
+  }
+  return r;
+}
+
+// bytes, with an optional suffix k, m or g
+static int64_t parseSize(const char * s){
+  char * e;
+  int64_t x = strtoll(s, &e, 10);
+  switch(tolower(*e)){
+  case 'g': x <<= 10;
+    // fall through
+  case 'm': x <<= 10;
+    // fall through
+  case 'k': x <<= 10;
+  }
+  return x;
+}
+
+void print_usage_stream(char * argv []){
+  std::cout << "Usage  : " << argv[0] << " [options]" << std::endl
+	    << "Options: " << std::endl
+	    << "  -f iFile : file to process (default: standard input)" << std::endl
+	    << "  -w size  : maximum distance of the previous occurrences, in bytes," << std::endl
+	    << "             or with suffix k, m, g (default: 1m, at most 1g)" << std::endl
+	    << "  -g       : check if resulting factorization produces input string" << std::endl
+	    << "             (keeps the whole input in memory)" << std::endl
+	    << "  -o oFile : write the factorization to oFile" << std::endl
+	    << "  -t num   : number of threads (requires OpenMP, default: all cores)" << std::endl;
+}
+
+int main(int argc, char * argv[]){
+  int ch;
+  int64_t w = 1 << 20;
+  std::string inFile;
+  while ((ch = getopt(argc, argv, "f:w:go:t:h")) != -1) {
+    switch (ch) {
+    case 'f':
+      inFile = optarg;
+      break;
+    case 'w':
+      w = parseSize(optarg);
+      break;
+    case 'g':
+      checkResult = true;
+      break;
+    case 'o':
+      outFile = optarg;
+      break;
+    case 't':
+      setThreads(atoi(optarg));
+      break;
+    default:
+      print_usage_stream(argv);
+      exit(0);
+    }
+  }
+  if(w < 2 || w > (int64_t(1) << 30)){
+    print_usage_stream(argv);
+    exit(0);
+  }
+  int fd = inFile.empty() ? 0 : open(inFile.c_str(), O_RDONLY);
+  if(fd < 0){
+    std::cerr << "failed to read file: " << inFile << std::endl;
+    return 1;
+  }
+
+  ////////////////////////////////////////////////////////////
+  // the stream is processed in windows of w characters: the last
+  // w/2 characters of the previous window, followed by w/2 new ones.
+  // the factors of the new characters refer to positions in the
+  // window only, i.e., less than w characters back (and at least
+  // w/2 characters back are searched), and are cut at the end of
+  // the window. the first window is filled with new characters.
+  ////////////////////////////////////////////////////////////
+  const int32_t W = static_cast<int32_t>(w), H = W / 2;
+  std::vector<char> buf(W);
+  std::vector<int32_t> sa(W), psv(W);
+  std::vector<std::pair<savalue_t,savalue_t> > lz;
+  std::string text;
+  FileSink * out = outFile.empty() ? 0 : new FileSink(outFile, -1);
+  CountSink count(checkResult ? &lz : 0, out); // keep factors only for checking
+  OffsetSink sink(count);
+
+  double t1 = gettime(), tsa = 0, tpnsv = 0, tlz = 0;
+  int64_t pos = 0;  // position of the window in the stream
+  int32_t start = 0, len = readBlock(fd, &buf[0], W);
+  while(len > start){
+    if(checkResult) text.append(&buf[start], len - start);
+    double t2 = gettime();
+    divsufsort(reinterpret_cast<const unsigned char *>(&buf[0]), &sa[0], len, W);
+    double t3 = gettime();
+    pnsvTextFromSA(&sa[0], len, &psv[0]);
+    double t4 = gettime();
+    sink.offset = pos;
+    lzFromTOPNSV(&buf[0], len, start, &psv[0], &sa[0], sink);
+    double t5 = gettime();
+    tsa += t3 - t2; tpnsv += t4 - t3; tlz += t5 - t4;
+    if(len < W) break; // end of the stream
+    memmove(&buf[0], &buf[len - H], H);
+    pos += len - H;
+    start = H;
+    len = H + readBlock(fd, &buf[H], W - H);
+  }
+  const int64_t n = pos + len;
+  if(fd != 0) close(fd);
+  const bool written = !out || out->close(); // reports a failure
+  delete out;
+  if(!written) return 1;
+
+  std::cout << "Time for sa: " << tsa << std::endl;
+  std::cout << "Time for pnsv: " << tpnsv << std::endl;
+  std::cout << "Time for lz: " << tlz << std::endl;
+  std::cout << "text length: " << n << std::endl;
+  std::cout << "window: " << W << " (working memory " << 9 * int64_t(W) << " bytes)" << std::endl;
+  std::cout << "# of lz factors: " << count.count << std::endl;
+  std::cout << "Total: " << gettime() - t1 << std::endl;
+  if(checkResult){
+    if(lz2str(lz) != text) std::cerr << "CHECK: ERROR: mismatch" << std::endl;
+    else std::cerr << "CHECK: OK" << std::endl;
+  }
+  return 0;
+}